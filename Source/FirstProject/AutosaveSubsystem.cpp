@@ -0,0 +1,301 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AutosaveSubsystem.h"
+#include "FirstProject.h"
+#include "Main.h"
+#include "Async/Async.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+
+DECLARE_CYCLE_STAT(TEXT("Save Snapshot"), STAT_SaveSnapshot, STATGROUP_FirstProject);
+
+static TAutoConsoleVariable<float> CVarAutosaveInterval(
+	TEXT("FirstProject.Autosave.Interval"),
+	120.f,
+	TEXT("Seconds between periodic autosaves, 0 disables them"));
+
+static TAutoConsoleVariable<float> CVarAutosaveCoalesceDelay(
+	TEXT("FirstProject.Autosave.CoalesceDelay"),
+	0.5f,
+	TEXT("Seconds a save request waits for further requests before it is written"));
+
+UAutosaveSubsystem::UAutosaveSubsystem()
+{
+	PendingSince = 0.0;
+	InFlightReason = EAutosaveReason::Manual;
+	NextPeriodicSave = 0.0;
+	LoadedPlayTime = 0.f;
+	LoadedAt = 0.0;
+	bSaveOnPlayerStart = false;
+}
+
+void UAutosaveSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	ActiveSlot = GetDefault<UFirstSaveGame>()->PlayerName;
+	LoadedAt = FPlatformTime::Seconds();
+}
+
+void UAutosaveSubsystem::RequestAutosave(const UObject* WorldContextObject, EAutosaveReason Reason)
+{
+	AMain* Main = Cast<AMain>(UGameplayStatics::GetPlayerPawn(WorldContextObject, 0));
+	if (Main && Main->MovementStatus != EMovementStatus::EMS_Dead)
+	{
+		SaveMain(Main, Reason);
+	}
+}
+
+void UAutosaveSubsystem::SaveMain(AMain* Main, EAutosaveReason Reason, FName NextLevel)
+{
+	UGameInstance* GameInstance = Main->GetGameInstance();
+	UAutosaveSubsystem* Autosave = GameInstance ? GameInstance->GetSubsystem<UAutosaveSubsystem>() : nullptr;
+
+	FSaveSnapshot Snapshot = MakeSnapshot(Main, Autosave, Reason, NextLevel);
+	if (Autosave)
+	{
+		Autosave->QueueSnapshot(MoveTemp(Snapshot));
+		Autosave->bSaveOnPlayerStart = NextLevel != NAME_None;
+	}
+	else
+	{
+		UFirstSaveGame::WriteSlot(Snapshot.Data, Snapshot.SlotName, Snapshot.UserIndex);
+	}
+}
+
+void UAutosaveSubsystem::NotifyPlayerStarted(AMain* Main)
+{
+	UGameInstance* GameInstance = Main->GetGameInstance();
+	UAutosaveSubsystem* Autosave = GameInstance ? GameInstance->GetSubsystem<UAutosaveSubsystem>() : nullptr;
+	if (Autosave && Autosave->bSaveOnPlayerStart)
+	{
+		Autosave->bSaveOnPlayerStart = false;
+		SaveMain(Main, EAutosaveReason::LevelTransition);
+	}
+}
+
+bool UAutosaveSubsystem::LoadMain(const AMain* Main, FSaveGameData& OutData)
+{
+	UGameInstance* GameInstance = Main->GetGameInstance();
+	UAutosaveSubsystem* Autosave = GameInstance ? GameInstance->GetSubsystem<UAutosaveSubsystem>() : nullptr;
+	const UFirstSaveGame* SaveDefaults = GetDefault<UFirstSaveGame>();
+	if (!Autosave)
+	{
+		return UFirstSaveGame::ReadSlot(SaveDefaults->PlayerName, SaveDefaults->UserIndex, OutData);
+	}
+
+	// The newest state may still be queued
+	Autosave->Flush();
+
+	if (!UFirstSaveGame::ReadSlot(Autosave->ActiveSlot, SaveDefaults->UserIndex, OutData))
+	{
+		return false;
+	}
+	Autosave->LoadedPlayTime = OutData.PlayTime;
+	Autosave->LoadedAt = FPlatformTime::Seconds();
+	return true;
+}
+
+void UAutosaveSubsystem::SetActiveSlot(const UObject* WorldContextObject, const FString& SlotName)
+{
+	UWorld* World = WorldContextObject->GetWorld();
+	UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	UAutosaveSubsystem* Autosave = GameInstance ? GameInstance->GetSubsystem<UAutosaveSubsystem>() : nullptr;
+	if (!UFirstSaveGame::IsValidSlotName(SlotName))
+	{
+		UE_LOG(LogFirstProject, Warning, TEXT("'%s' can't be a save slot name"), *SlotName);
+		return;
+	}
+
+	if (Autosave)
+	{
+		// Snapshots already queued keep the slot they were taken for
+		Autosave->ActiveSlot = SlotName;
+		// Play time counts from zero until the slot is loaded
+		Autosave->LoadedPlayTime = 0.f;
+		Autosave->LoadedAt = FPlatformTime::Seconds();
+	}
+}
+
+FString UAutosaveSubsystem::GetActiveSlot(const UObject* WorldContextObject)
+{
+	UWorld* World = WorldContextObject->GetWorld();
+	UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	UAutosaveSubsystem* Autosave = GameInstance ? GameInstance->GetSubsystem<UAutosaveSubsystem>() : nullptr;
+	return Autosave ? Autosave->ActiveSlot : GetDefault<UFirstSaveGame>()->PlayerName;
+}
+
+float UAutosaveSubsystem::GetPlayTime() const
+{
+	return LoadedPlayTime + static_cast<float>(FPlatformTime::Seconds() - LoadedAt);
+}
+
+FSaveSnapshot UAutosaveSubsystem::MakeSnapshot(const AMain* Main, const UAutosaveSubsystem* Autosave, EAutosaveReason Reason, FName NextLevel)
+{
+	// Game thread share of every save, manual or automatic. The disk write is timed by WriteSlot
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_SaveSnapshot);
+	CSV_SCOPED_TIMING_STAT(FirstProject, SaveSnapshot);
+
+	const UFirstSaveGame* SaveDefaults = GetDefault<UFirstSaveGame>();
+
+	FSaveSnapshot Snapshot;
+	Snapshot.SlotName = Autosave ? Autosave->ActiveSlot : SaveDefaults->PlayerName;
+	Snapshot.UserIndex = SaveDefaults->UserIndex;
+	Snapshot.Reason = Reason;
+	Main->CaptureSaveData(Snapshot.Data);
+	if (NextLevel != NAME_None)
+	{
+		// Loading this save before the one taken in the new level still ends up there, not back on the transition
+		Snapshot.Data.CharacterStats.LevelName = NextLevel.ToString();
+	}
+	if (Autosave)
+	{
+		Snapshot.Data.PlayTime = Autosave->GetPlayTime();
+	}
+	return Snapshot;
+}
+
+void UAutosaveSubsystem::QueueSnapshot(FSaveSnapshot&& Snapshot)
+{
+	// The delay runs from the first request, later ones only replace the state that gets written
+	if (!Pending.IsSet())
+	{
+		PendingSince = FPlatformTime::Seconds();
+	}
+	Pending = MoveTemp(Snapshot);
+}
+
+void UAutosaveSubsystem::Flush()
+{
+	if (InFlight.IsValid())
+	{
+		InFlight.Wait();
+		FinishWrite();
+	}
+
+	if (Pending.IsSet())
+	{
+		const FSaveSnapshot& Snapshot = Pending.GetValue();
+		if (!UFirstSaveGame::WriteSlot(Snapshot.Data, Snapshot.SlotName, Snapshot.UserIndex))
+		{
+			UE_LOG(LogFirstProject, Warning, TEXT("Saving slot %s failed"), *Snapshot.SlotName);
+		}
+		Pending.Reset();
+	}
+}
+
+void UAutosaveSubsystem::StartWrite()
+{
+	InFlightReason = Pending->Reason;
+	InFlight = Async(EAsyncExecution::ThreadPool, [Snapshot = MoveTemp(Pending.GetValue())]()
+	{
+		return UFirstSaveGame::WriteSlot(Snapshot.Data, Snapshot.SlotName, Snapshot.UserIndex);
+	});
+	Pending.Reset();
+}
+
+void UAutosaveSubsystem::FinishWrite()
+{
+	const bool bSaved = InFlight.Get();
+	InFlight = TFuture<bool>();
+
+	if (bSaved)
+	{
+		UE_LOG(LogFirstProject, Verbose, TEXT("Saved (%s)"), *UEnum::GetValueAsString(InFlightReason));
+	}
+	else
+	{
+		UE_LOG(LogFirstProject, Warning, TEXT("Background save (%s) failed"), *UEnum::GetValueAsString(InFlightReason));
+	}
+}
+
+void UAutosaveSubsystem::Deinitialize()
+{
+	// Don't lose the last save when the game quits
+	Flush();
+
+	Super::Deinitialize();
+}
+
+void UAutosaveSubsystem::Tick(float DeltaTime)
+{
+	if (InFlight.IsValid() && InFlight.IsReady())
+	{
+		FinishWrite();
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	if (Pending.IsSet() && !InFlight.IsValid() && Now - PendingSince >= CVarAutosaveCoalesceDelay.GetValueOnGameThread())
+	{
+		StartWrite();
+	}
+
+	const float Interval = CVarAutosaveInterval.GetValueOnGameThread();
+	if (Interval <= 0.f)
+	{
+		NextPeriodicSave = 0.0;
+	}
+	else if (NextPeriodicSave == 0.0)
+	{
+		NextPeriodicSave = Now + Interval;
+	}
+	else if (Now >= NextPeriodicSave)
+	{
+		NextPeriodicSave = Now + Interval;
+
+		UWorld* World = GetGameInstance()->GetWorld();
+		if (World && !World->IsPaused())
+		{
+			RequestAutosave(World, EAutosaveReason::Periodic);
+		}
+	}
+}
+
+bool UAutosaveSubsystem::IsTickable() const
+{
+	return true;
+}
+
+bool UAutosaveSubsystem::IsTickableWhenPaused() const
+{
+	// Writes queued before pausing still go out
+	return true;
+}
+
+ETickableTickType UAutosaveSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId UAutosaveSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAutosaveSubsystem, STATGROUP_Tickables);
+}
+
+#if FIRSTPROJECT_DEBUG_TOOLS
+
+static FAutoConsoleCommandWithWorldAndArgs SaveSlotCommand(
+	TEXT("FirstProject.SaveSlot"),
+	TEXT("List the save slots, or make Name the slot saves and loads use. Usage: FirstProject.SaveSlot [Name]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (World && Args.Num() > 0)
+		{
+			UAutosaveSubsystem::SetActiveSlot(World, Args[0]);
+		}
+
+		for (const FSaveSlotInfo& Slot : UFirstSaveGame::ListSlots())
+		{
+			UE_LOG(LogFirstProject, Display, TEXT("%s: %s, %d coins, %s played, saved %s (version %d)"),
+				*Slot.SlotName, *Slot.LevelName, Slot.Coins, *FTimespan::FromSeconds(Slot.PlayTime).ToString(TEXT("%h:%m:%s")),
+				*Slot.Timestamp.ToString(), Slot.Version);
+		}
+		if (World)
+		{
+			UE_LOG(LogFirstProject, Display, TEXT("Active slot: %s"), *UAutosaveSubsystem::GetActiveSlot(World));
+		}
+	}));
+
+#endif
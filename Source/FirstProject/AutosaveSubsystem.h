@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
+#include "Async/Future.h"
+#include "FirstSaveGame.h"
+#include "AutosaveSubsystem.generated.h"
+
+UENUM(BlueprintType)
+enum class EAutosaveReason : uint8
+{
+	Manual,
+	Periodic,
+	LevelTransition,
+	Checkpoint,
+	BossKill
+};
+
+/** Everything a background write needs, no UObjects */
+struct FSaveSnapshot
+{
+	FString SlotName;
+
+	int32 UserIndex;
+
+	FSaveGameData Data;
+
+	EAutosaveReason Reason;
+
+	FSaveSnapshot()
+		: UserIndex(0)
+		, Reason(EAutosaveReason::Manual)
+	{
+	}
+};
+
+/**
+ * Writes save slots in the background.
+ * The game thread only copies the player's state into a snapshot; serialization, compression and the disk write
+ * run on the thread pool. Requests arriving while a write is queued or in flight replace the queued snapshot,
+ * so a burst of triggers ends up as a single write of the latest state.
+ *
+ * Autosaves run every FirstProject.Autosave.Interval seconds, on level transitions, on the death of enemies
+ * flagged bAutosaveOnDeath and when Blueprints call RequestAutosave, for example from checkpoint triggers.
+ * Saves and loads go to the active slot, which save menus pick with SetActiveSlot.
+ */
+UCLASS()
+class FIRSTPROJECT_API UAutosaveSubsystem : public UGameInstanceSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UAutosaveSubsystem();
+
+	/** Snapshot the player's state and save it in the background */
+	UFUNCTION(BlueprintCallable, Category = "SaveData", meta = (WorldContext = "WorldContextObject"))
+	static void RequestAutosave(const UObject* WorldContextObject, EAutosaveReason Reason);
+
+	/**
+	 * Save Main's state. Writes in the background, or right away when there is no game instance to own the write.
+	 * NextLevel is set when Main is about to leave for it: the save then loads into NextLevel, and is taken again
+	 * once the player starts there so it gets the position in the new level.
+	 */
+	static void SaveMain(class AMain* Main, EAutosaveReason Reason, FName NextLevel = NAME_None);
+
+	/** Take the save a level transition left for the level the player just started in. Called from the player's BeginPlay */
+	static void NotifyPlayerStarted(class AMain* Main);
+
+	/** Read the active slot, finishing any queued or running write first */
+	static bool LoadMain(const AMain* Main, FSaveGameData& OutData);
+
+	/** Slot later saves and loads use. Doesn't load it, and ignores names that aren't valid file names */
+	UFUNCTION(BlueprintCallable, Category = "SaveData", meta = (WorldContext = "WorldContextObject"))
+	static void SetActiveSlot(const UObject* WorldContextObject, const FString& SlotName);
+
+	UFUNCTION(BlueprintPure, Category = "SaveData", meta = (WorldContext = "WorldContextObject"))
+	static FString GetActiveSlot(const UObject* WorldContextObject);
+
+	/** Seconds played on the active slot, including the sessions before the last load */
+	float GetPlayTime() const;
+
+	void QueueSnapshot(FSaveSnapshot&& Snapshot);
+
+	/** Block until the queued and running writes are on disk */
+	void Flush();
+
+	FORCEINLINE bool IsSaving() const { return InFlight.IsValid() || Pending.IsSet(); }
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual bool IsTickableWhenPaused() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	static FSaveSnapshot MakeSnapshot(const AMain* Main, const UAutosaveSubsystem* Autosave, EAutosaveReason Reason, FName NextLevel);
+
+	void StartWrite();
+
+	void FinishWrite();
+
+	/** Latest snapshot waiting for the coalescing delay or for the running write to end */
+	TOptional<FSaveSnapshot> Pending;
+
+	double PendingSince;
+
+	TFuture<bool> InFlight;
+
+	EAutosaveReason InFlightReason;
+
+	double NextPeriodicSave;
+
+	FString ActiveSlot;
+
+	/** Play time loaded from the slot, and when it was loaded */
+	float LoadedPlayTime;
+	double LoadedAt;
+
+	/** A level transition was saved on the way out, save again when the player starts in the new level */
+	bool bSaveOnPlayerStart;
+};
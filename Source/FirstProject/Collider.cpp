@@ -58,7 +58,9 @@ ACollider::ACollider()
 void ACollider::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	// The sphere moves in fixed steps, the mesh is drawn in between
+	OurMovementComponent->SetInterpolatedComponent(MeshComponent);
 }
 
 // Called every frame
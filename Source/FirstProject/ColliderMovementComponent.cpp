@@ -2,6 +2,37 @@
 
 
 #include "ColliderMovementComponent.h"
+#include "FirstProject.h"
+
+UColliderMovementComponent::UColliderMovementComponent()
+{
+	// Same speed the unscaled per frame move had at 60 fps
+	MaxSpeed = 60.f;
+
+	bFixedTimestep = true;
+	FixedTimestep = 1.f / 60.f;
+	MaxSubsteps = 4;
+
+	InterpolatedComponent = nullptr;
+	InterpolatedBaseLocation = FVector::ZeroVector;
+	PreviousStepLocation = FVector::ZeroVector;
+	LastStepLocation = FVector::ZeroVector;
+	TimeAccumulator = 0.f;
+}
+
+void UColliderMovementComponent::SetInterpolatedComponent(USceneComponent* Component)
+{
+	if (InterpolatedComponent)
+	{
+		InterpolatedComponent->SetRelativeLocation(InterpolatedBaseLocation);
+	}
+
+	InterpolatedComponent = Component;
+	if (InterpolatedComponent)
+	{
+		InterpolatedBaseLocation = InterpolatedComponent->GetRelativeLocation();
+	}
+}
 
 void UColliderMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType,
 	FActorComponentTickFunction* ThisTickFunction)
@@ -13,20 +44,71 @@ void UColliderMovementComponent::TickComponent(float DeltaTime, ELevelTick TickT
 		return;
 	}
 
-	FVector DesiredMovementThisFrame = ConsumeInputVector().GetClampedToMaxSize(1.0f);
+	Velocity = ConsumeInputVector().GetClampedToMaxSize(1.0f) * MaxSpeed;
+
+	if (!bFixedTimestep || FixedTimestep <= 0.f)
+	{
+		MoveStep(DeltaTime);
+		UpdateComponentVelocity();
+		return;
+	}
 
-	if(!DesiredMovementThisFrame.IsNearlyZero())
+	// Moved by something else since the last step, don't interpolate across it
+	const FVector CurrentLocation = UpdatedComponent->GetComponentLocation();
+	if (!CurrentLocation.Equals(LastStepLocation))
 	{
-		FHitResult Hit;
-		SafeMoveUpdatedComponent(DesiredMovementThisFrame, UpdatedComponent->GetComponentRotation(), true , Hit);
+		PreviousStepLocation = CurrentLocation;
+		LastStepLocation = CurrentLocation;
+	}
 
-		if(Hit.IsValidBlockingHit())
-		{
-			UE_LOG(LogTemp, Warning, TEXT("Valid Blocaking Hit"));
-			SlideAlongSurface(DesiredMovementThisFrame, 1.f - Hit.Time, Hit.Normal, Hit);	
-		}
+	TimeAccumulator += DeltaTime;
+	int32 Steps = FMath::FloorToInt(TimeAccumulator / FixedTimestep);
+	if (Steps > MaxSubsteps)
+	{
+		Steps = MaxSubsteps;
+		TimeAccumulator = Steps * FixedTimestep;
+	}
+
+	// At frame rates above the step rate most frames run no sweep at all
+	for (int32 Step = 0; Step < Steps; ++Step)
+	{
+		PreviousStepLocation = LastStepLocation;
+		MoveStep(FixedTimestep);
+		LastStepLocation = UpdatedComponent->GetComponentLocation();
+		TimeAccumulator -= FixedTimestep;
+	}
+
+	UpdateComponentVelocity();
+	ApplyInterpolation(TimeAccumulator / FixedTimestep);
+}
+
+void UColliderMovementComponent::MoveStep(float StepTime)
+{
+	const FVector Delta = Velocity * StepTime;
+	if(Delta.IsNearlyZero())
+	{
+		return;
+	}
+
+	FHitResult Hit;
+	SafeMoveUpdatedComponent(Delta, UpdatedComponent->GetComponentRotation(), true , Hit);
+
+	if(Hit.IsValidBlockingHit())
+	{
+		FIRSTPROJECT_HOT_LOG(VeryVerbose, TEXT("Valid Blocaking Hit"));
+		SlideAlongSurface(Delta, 1.f - Hit.Time, Hit.Normal, Hit);	
+	}
+}
+
+void UColliderMovementComponent::ApplyInterpolation(float Alpha)
+{
+	if (!InterpolatedComponent)
+	{
+		return;
 	}
 
-	
-	
+	// Draw where the body was Alpha of the way through the step in progress, one step behind the simulation
+	const FVector Smoothed = FMath::Lerp(PreviousStepLocation, LastStepLocation, Alpha);
+	const FVector Offset = UpdatedComponent->GetComponentTransform().InverseTransformVector(Smoothed - LastStepLocation);
+	InterpolatedComponent->SetRelativeLocation(InterpolatedBaseLocation + Offset);
 }
@@ -7,7 +7,9 @@
 #include "ColliderMovementComponent.generated.h"
 
 /**
- * 
+ * Moves the collider pawn at MaxSpeed along its input.
+ * In fixed timestep mode the simulation advances in FixedTimestep steps and the visual
+ * component is interpolated between the last two steps, so results don't depend on frame rate.
  */
 UCLASS()
 class FIRSTPROJECT_API UColliderMovementComponent : public UPawnMovementComponent
@@ -16,6 +18,43 @@ class FIRSTPROJECT_API UColliderMovementComponent : public UPawnMovementComponen
 
 public:
 
+	UColliderMovementComponent();
+
+	/** Speed in units per second at full input */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	float MaxSpeed;
+
+	/** Simulate in fixed steps instead of once per frame */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	bool bFixedTimestep;
+
+	/** Seconds per simulation step */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement", meta = (EditCondition = "bFixedTimestep", ClampMin = "0.001"))
+	float FixedTimestep;
+
+	/** Most steps run in one frame, time beyond that is dropped so a hitch can't snowball */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement", meta = (EditCondition = "bFixedTimestep", ClampMin = "1"))
+	int32 MaxSubsteps;
+
+	/** Component drawn between simulation steps, must be attached below the updated component */
+	void SetInterpolatedComponent(USceneComponent* Component);
+
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
-	
+
+private:
+
+	void MoveStep(float StepTime);
+
+	void ApplyInterpolation(float Alpha);
+
+	UPROPERTY()
+	USceneComponent* InterpolatedComponent;
+
+	FVector InterpolatedBaseLocation;
+
+	/** Updated component location before the last step and after it */
+	FVector PreviousStepLocation;
+	FVector LastStepLocation;
+
+	float TimeAccumulator;
 };
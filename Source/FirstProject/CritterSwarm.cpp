@@ -0,0 +1,243 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CritterSwarm.h"
+#include "FirstProject.h"
+#include "Async/ParallelFor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/AutomationTest.h"
+#include "TestWorld.h"
+
+DECLARE_CYCLE_STAT(TEXT("Critter Swarm Update"), STAT_CritterSwarmUpdate, STATGROUP_FirstProject);
+
+namespace CritterSwarm
+{
+	/** Critters per ParallelFor task */
+	const int32 BatchSize = 512;
+
+	/** xorshift32, cheap and independent per critter so workers never share random state */
+	FORCEINLINE float NextSignedUnit(uint32& State)
+	{
+		State ^= State << 13;
+		State ^= State >> 17;
+		State ^= State << 5;
+		return (State & 0xFFFFFF) / static_cast<float>(0x800000) - 1.f;
+	}
+}
+
+ACritterSwarm::ACritterSwarm()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	Instances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("Instances"));
+	RootComponent = Instances;
+	Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Instances->SetCastShadow(false);
+
+	NumCritters = 1000;
+	SwarmRadius = 1500.f;
+	MaxSpeed = 100.f;
+	CritterScale = FVector(1.f);
+	Steering = 2.f;
+	WanderJitter = 180.f;
+	Seed = 0;
+
+	LastUpdateSeconds = 0.0;
+}
+
+void ACritterSwarm::BeginPlay()
+{
+	Super::BeginPlay();
+
+	SpawnCritters(NumCritters);
+}
+
+void ACritterSwarm::SpawnCritters(int32 Count)
+{
+	Count = FMath::Max(Count, 0);
+	NumCritters = Count;
+
+	FRandomStream Stream(Seed);
+	const FVector Origin = GetActorLocation();
+
+	Positions.SetNumUninitialized(Count);
+	Velocities.SetNumUninitialized(Count);
+	WanderHeadings.SetNumUninitialized(Count);
+	RandomStates.SetNumUninitialized(Count);
+	InstanceTransforms.SetNum(Count);
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const float Angle = Stream.FRandRange(0.f, 2.f * PI);
+		const float Distance = FMath::Sqrt(Stream.FRand()) * SwarmRadius;
+		Positions[Index] = Origin + FVector(FMath::Cos(Angle) * Distance, FMath::Sin(Angle) * Distance, 0.f);
+		WanderHeadings[Index] = Stream.FRandRange(0.f, 2.f * PI);
+		Velocities[Index] = FVector(FMath::Cos(WanderHeadings[Index]), FMath::Sin(WanderHeadings[Index]), 0.f) * MaxSpeed;
+		// xorshift must not start at zero
+		RandomStates[Index] = static_cast<uint32>(Stream.GetUnsignedInt()) | 1u;
+		InstanceTransforms[Index] = FTransform(Velocities[Index].ToOrientationQuat(), Positions[Index], CritterScale);
+	}
+
+	Instances->ClearInstances();
+	Instances->AddInstances(InstanceTransforms, false);
+	SetActorTickEnabled(Count > 0);
+}
+
+void ACritterSwarm::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_CritterSwarmUpdate);
+	const double StartTime = FPlatformTime::Seconds();
+
+	Simulate(DeltaTime);
+	// One render state update for the whole swarm, teleported so no physics state is touched
+	Instances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+
+	LastUpdateSeconds = FPlatformTime::Seconds() - StartTime;
+}
+
+void ACritterSwarm::Simulate(float DeltaTime)
+{
+	const int32 Count = Positions.Num();
+	const int32 NumBatches = FMath::DivideAndRoundUp(Count, CritterSwarm::BatchSize);
+
+	const FVector Origin = GetActorLocation();
+	const float RadiusSquared = FMath::Square(SwarmRadius);
+	const float JitterRadians = FMath::DegreesToRadians(WanderJitter) * DeltaTime;
+	const float SteerAlpha = FMath::Clamp(Steering * DeltaTime, 0.f, 1.f);
+	const float Speed = MaxSpeed;
+
+	FVector* RESTRICT PositionData = Positions.GetData();
+	FVector* RESTRICT VelocityData = Velocities.GetData();
+	float* RESTRICT HeadingData = WanderHeadings.GetData();
+	uint32* RESTRICT RandomData = RandomStates.GetData();
+	FTransform* RESTRICT TransformData = InstanceTransforms.GetData();
+
+	ParallelFor(NumBatches, [=](int32 Batch)
+	{
+		const int32 First = Batch * CritterSwarm::BatchSize;
+		const int32 Last = FMath::Min(First + CritterSwarm::BatchSize, Count);
+		for (int32 Index = First; Index < Last; ++Index)
+		{
+			float Heading = HeadingData[Index] + CritterSwarm::NextSignedUnit(RandomData[Index]) * JitterRadians;
+
+			// Outside the swarm radius the wander heading is pulled back towards the middle
+			const FVector ToOrigin = Origin - PositionData[Index];
+			if (ToOrigin.SizeSquared2D() > RadiusSquared)
+			{
+				Heading = FMath::Atan2(ToOrigin.Y, ToOrigin.X);
+			}
+			HeadingData[Index] = Heading;
+
+			const FVector Desired(FMath::Cos(Heading) * Speed, FMath::Sin(Heading) * Speed, 0.f);
+			VelocityData[Index] = FMath::Lerp(VelocityData[Index], Desired, SteerAlpha);
+			PositionData[Index] += VelocityData[Index] * DeltaTime;
+
+			TransformData[Index].SetLocation(PositionData[Index]);
+			if (!VelocityData[Index].IsNearlyZero())
+			{
+				TransformData[Index].SetRotation(VelocityData[Index].ToOrientationQuat());
+			}
+		}
+	});
+}
+
+#if FIRSTPROJECT_DEBUG_TOOLS
+
+/** Benchmark helper: watch stat FirstProject or run FirstProject.CritterSwarmStats afterwards */
+static FAutoConsoleCommandWithWorldAndArgs SpawnCritterSwarmCommand(
+	TEXT("FirstProject.SpawnCritterSwarm"),
+	TEXT("Spawn a critter swarm around the player. Usage: FirstProject.SpawnCritterSwarm [Count=10000] [MeshPath=/Engine/BasicShapes/Cone.Cone]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		APawn* Player = World ? UGameplayStatics::GetPlayerPawn(World, 0) : nullptr;
+		if (!Player)
+		{
+			return;
+		}
+
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+		UStaticMesh* Mesh = LoadObject<UStaticMesh>(nullptr, Args.Num() > 1 ? *Args[1] : TEXT("/Engine/BasicShapes/Cone.Cone"));
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		SpawnParams.bDeferConstruction = true;
+
+		ACritterSwarm* Swarm = World->SpawnActor<ACritterSwarm>(Player->GetActorLocation(), FRotator::ZeroRotator, SpawnParams);
+		if (Swarm)
+		{
+			Swarm->NumCritters = Count;
+			Swarm->SwarmRadius = FMath::Sqrt(static_cast<float>(Count)) * 30.f;
+			Swarm->CritterScale = FVector(0.2f);
+			Swarm->Instances->SetStaticMesh(Mesh);
+			UGameplayStatics::FinishSpawningActor(Swarm, FTransform(Player->GetActorLocation()));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld CritterSwarmStatsCommand(
+	TEXT("FirstProject.CritterSwarmStats"),
+	TEXT("Log critter counts and the game thread cost of each swarm's last update"),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (!World)
+		{
+			return;
+		}
+
+		for (TActorIterator<ACritterSwarm> It(World); It; ++It)
+		{
+			UE_LOG(LogFirstProject, Log, TEXT("%s: %d critters, last update %.3f ms"),
+				*It->GetName(), It->GetNumCritters(), It->GetLastUpdateSeconds() * 1000.0);
+		}
+	}));
+
+#endif
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCritterSwarmUpdateTest, "FirstProject.Performance.CritterSwarm.Update10000",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+/** Game thread cost of one update of 10,000 critters, median of fixed 60 Hz frames after a warm-up */
+bool FCritterSwarmUpdateTest::RunTest(const FString& Parameters)
+{
+	const int32 NumCritters = 10000;
+	const int32 WarmupFrames = 30;
+	const int32 TimedFrames = 300;
+
+	FFirstProjectTestWorld TestWorld(TEXT("CritterSwarmUpdateTest"));
+	ACritterSwarm* Swarm = TestWorld.Spawn<ACritterSwarm>();
+	Swarm->Instances->SetStaticMesh(LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cone.Cone")));
+	Swarm->SwarmRadius = FMath::Sqrt(static_cast<float>(NumCritters)) * 30.f;
+	Swarm->Seed = 1;
+	Swarm->SpawnCritters(NumCritters);
+
+	for (int32 Frame = 0; Frame < WarmupFrames; ++Frame)
+	{
+		Swarm->Tick(1.f / 60.f);
+	}
+
+	TArray<double> Milliseconds;
+	Milliseconds.Reserve(TimedFrames);
+	for (int32 Frame = 0; Frame < TimedFrames; ++Frame)
+	{
+		Swarm->Tick(1.f / 60.f);
+		Milliseconds.Add(Swarm->GetLastUpdateSeconds() * 1000.0);
+	}
+	Milliseconds.Sort();
+
+	const double Median = Milliseconds[TimedFrames / 2];
+	AddInfo(FString::Printf(TEXT("%d critters: %.3f ms per update (median of %d), %.3f ms at the 95th percentile"),
+		NumCritters, Median, TimedFrames, Milliseconds[TimedFrames * 95 / 100]));
+	UE_LOG(LogFirstProject, Display, TEXT("CritterSwarm.Update%d: %.3f ms per update"), NumCritters, Median);
+
+	TestEqual(TEXT("Critters spawned"), Swarm->GetNumCritters(), NumCritters);
+	return true;
+}
+
+#endif
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CritterSwarm.generated.h"
+
+/**
+ * Ambient critters wandering around the actor, simulated as plain arrays and drawn as instances.
+ * Thousands of critters cost one actor tick and one instanced mesh component, not an actor each.
+ */
+UCLASS()
+class FIRSTPROJECT_API ACritterSwarm : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	ACritterSwarm();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Swarm")
+	class UInstancedStaticMeshComponent* Instances;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Swarm", meta = (ClampMin = "0"))
+	int32 NumCritters;
+
+	/** Critters are spawned in and steered back into this radius around the actor */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Swarm")
+	float SwarmRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Swarm")
+	float MaxSpeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Swarm")
+	FVector CritterScale;
+
+	/** How quickly velocity turns towards the desired heading, per second */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Swarm")
+	float Steering;
+
+	/** Largest change of the wander heading, in degrees per second */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Swarm")
+	float WanderJitter;
+
+	/** Seed for the starting layout and the wander noise, the same seed replays the same swarm */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Swarm")
+	int32 Seed;
+
+	/** Rebuild the swarm with Count critters */
+	UFUNCTION(BlueprintCallable, Category = "Swarm")
+	void SpawnCritters(int32 Count);
+
+	FORCEINLINE int32 GetNumCritters() const { return Positions.Num(); }
+
+	/** Game thread seconds spent in the last simulate and instance update */
+	FORCEINLINE double GetLastUpdateSeconds() const { return LastUpdateSeconds; }
+
+	virtual void Tick(float DeltaTime) override;
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+
+	void Simulate(float DeltaTime);
+
+	/** Critter state, one entry per critter in every array */
+	TArray<FVector> Positions;
+	TArray<FVector> Velocities;
+	TArray<float> WanderHeadings;
+	TArray<uint32> RandomStates;
+
+	/** Reused every tick to avoid reallocating the transform array */
+	TArray<FTransform> InstanceTransforms;
+
+	double LastUpdateSeconds;
+};
@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CurveActuatorComponent.h"
+#include "FirstProject.h"
+#include "Curves/CurveFloat.h"
+
+UCurveActuatorComponent::UCurveActuatorComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	// Enabled by Play, disabled again once the curve reaches its end
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	Curve = nullptr;
+	Axis = FVector::UpVector;
+	PlayRate = 1.f;
+
+	Position = 0.f;
+	Direction = 0.f;
+}
+
+void UCurveActuatorComponent::AddTarget(USceneComponent* Target)
+{
+	if (Target && Target->Mobility != EComponentMobility::Movable)
+	{
+		UE_LOG(LogFirstProject, Warning, TEXT("%s can't drive %s of %s, it isn't Movable"),
+			*GetName(), *Target->GetName(), *GetNameSafe(Target->GetOwner()));
+		return;
+	}
+
+	if (Target && !Targets.Contains(Target))
+	{
+		Targets.Add(Target);
+		InitialLocations.Add(Target->GetComponentLocation());
+	}
+}
+
+void UCurveActuatorComponent::PlayForward()
+{
+	Play(1.f);
+}
+
+void UCurveActuatorComponent::Reverse()
+{
+	Play(-1.f);
+}
+
+void UCurveActuatorComponent::Play(float NewDirection)
+{
+	if (!Curve)
+	{
+		return;
+	}
+
+	float MinTime = 0.f;
+	float MaxTime = 0.f;
+	Curve->GetTimeRange(MinTime, MaxTime);
+	Position = FMath::Clamp(Position, MinTime, MaxTime);
+
+	const bool bAtEnd = NewDirection > 0.f ? Position >= MaxTime : Position <= MinTime;
+	if (!bAtEnd)
+	{
+		Direction = NewDirection;
+		SetComponentTickEnabled(true);
+	}
+}
+
+void UCurveActuatorComponent::TickComponent(float DeltaTime, ELevelTick TickType,
+	FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (!Curve || Direction == 0.f)
+	{
+		Direction = 0.f;
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	float MinTime = 0.f;
+	float MaxTime = 0.f;
+	Curve->GetTimeRange(MinTime, MaxTime);
+
+	Position = FMath::Clamp(Position + Direction * PlayRate * DeltaTime, MinTime, MaxTime);
+	ApplyPosition();
+
+	if ((Direction > 0.f && Position >= MaxTime) || (Direction < 0.f && Position <= MinTime))
+	{
+		Direction = 0.f;
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UCurveActuatorComponent::ApplyPosition()
+{
+	const FVector Offset = Axis * Curve->GetFloatValue(Position);
+	for (int32 Index = 0; Index < Targets.Num(); ++Index)
+	{
+		if (Targets[Index])
+		{
+			Targets[Index]->SetWorldLocation(InitialLocations[Index] + Offset);
+		}
+	}
+}
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "CurveActuatorComponent.generated.h"
+
+/**
+ * Moves a set of scene components along an axis by an offset read from a float curve.
+ * Only ticks while playing, so idle doors and switches cost nothing.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class FIRSTPROJECT_API UCurveActuatorComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UCurveActuatorComponent();
+
+	/** Offset along Axis over time, played forward to open and backward to close */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Actuator")
+	class UCurveFloat* Curve;
+
+	/** World space direction the offset is applied in */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Actuator")
+	FVector Axis;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Actuator")
+	float PlayRate;
+
+	/** Drive this component too, its current location becomes its closed location. Targets that aren't Movable are skipped with a warning */
+	UFUNCTION(BlueprintCallable, Category = "Actuator")
+	void AddTarget(USceneComponent* Target);
+
+	UFUNCTION(BlueprintCallable, Category = "Actuator")
+	void PlayForward();
+
+	UFUNCTION(BlueprintCallable, Category = "Actuator")
+	void Reverse();
+
+	UFUNCTION(BlueprintPure, Category = "Actuator")
+	FORCEINLINE bool IsMoving() const { return Direction != 0.f; }
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+private:
+
+	void Play(float NewDirection);
+
+	void ApplyPosition();
+
+	UPROPERTY()
+	TArray<USceneComponent*> Targets;
+
+	TArray<FVector> InitialLocations;
+
+	/** Current time on the curve */
+	float Position;
+
+	/** 1 playing forward, -1 reversing, 0 idle */
+	float Direction;
+};
@@ -2,6 +2,9 @@
 
 
 #include "Enemy.h"
+#include "FirstProject.h"
+#include "PerformanceSubsystem.h"
+#include "Particles/ParticleSystemComponent.h"
 #include "Components/SphereComponent.h"
 #include "Sound/SoundCue.h"
 #include "AIController.h"
@@ -18,8 +21,17 @@
 #include "Animation/AnimInstance.h"
 #include "TimerManager.h"
 #include "Components/CapsuleComponent.h"
+#include "ReplaySubsystem.h"
+#include "AutosaveSubsystem.h"
+#include "WorldStateSubsystem.h"
 #include "MainPlayerController.h"
 
+DECLARE_CYCLE_STAT(TEXT("Enemy Agro Overlap"), STAT_EnemyAgroOverlap, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Enemy Combat Sphere Overlap"), STAT_EnemyCombatSphereOverlap, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Enemy Combat Overlap"), STAT_EnemyCombatOverlap, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Enemy Attack"), STAT_EnemyAttack, STATGROUP_FirstProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Enemies"), STAT_LiveEnemies, STATGROUP_FirstProject);
+
 // Sets default values
 AEnemy::AEnemy()
 {
@@ -51,6 +63,8 @@ AEnemy::AEnemy()
 	EnemyMovementStatus = EEnemyMovementStatus::EMS_Idle;
 
 	DeathDelay = 3.f;
+	bAutosaveOnDeath = false;
+	WorldStateId = INDEX_NONE;
 
 	bHasValidTarget = false;
 }
@@ -77,6 +91,19 @@ void AEnemy::BeginPlay()
 
 	GetMesh()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Camera, ECollisionResponse::ECR_Ignore);
 	GetCapsuleComponent()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Camera, ECollisionResponse::ECR_Ignore);
+
+	INC_DWORD_STAT(STAT_LiveEnemies);
+}
+
+void AEnemy::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Dead enemies were already taken off the count in Die
+	if (Alive())
+	{
+		DEC_DWORD_STAT(STAT_LiveEnemies);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
@@ -96,12 +123,19 @@ void AEnemy::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 void AEnemy::AgroSphereOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
 	UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_EnemyAgroOverlap);
+
 	if(OtherActor && Alive())
 	{
 		AMain* Main = Cast<AMain>(OtherActor);
 		if (Main)
 		{
 			MoveToTarget(Main);
+
+			if (Main->MainPlayerController)
+			{
+				Main->MainPlayerController->AddEngagedEnemy(this);
+			}
 		}
 	}	
 }
@@ -109,6 +143,8 @@ void AEnemy::AgroSphereOnOverlapBegin(UPrimitiveComponent* OverlappedComponent,
 void AEnemy::AgroSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
 	UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
 {
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_EnemyAgroOverlap);
+
 	if(OtherActor)
 	{
 		AMain* Main = Cast<AMain>(OtherActor);
@@ -123,6 +159,11 @@ void AEnemy::AgroSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AA
 			Main->SetHasCombatTarget(false);
 	
 			Main->UpdateCombatTarget();
+
+			if (Main->MainPlayerController)
+			{
+				Main->MainPlayerController->RemoveEngagedEnemy(this);
+			}
 			
 			SetEnemyMovementStatus(EEnemyMovementStatus::EMS_Idle);
 			if(AIController)
@@ -136,6 +177,8 @@ void AEnemy::AgroSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AA
 void AEnemy::CombatSphereOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
 	UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_EnemyCombatSphereOverlap);
+
 	if(OtherActor && Alive())
 	{
 		AMain* Main = Cast<AMain>(OtherActor);
@@ -151,7 +194,7 @@ void AEnemy::CombatSphereOnOverlapBegin(UPrimitiveComponent* OverlappedComponent
 			CombatTarget = Main;
 			bOverlapCombatSphere = true;
 			
-			float AttackTime = FMath::FRandRange(AttackMinTime, AttackMaxTime);
+			float AttackTime = UReplaySubsystem::GetWorldRandom(this, EGameplayRandom::AI).FRandRange(AttackMinTime, AttackMaxTime);
 			GetWorldTimerManager().SetTimer(AttackTimer, this, &AEnemy::Attack, AttackTime);
 		}
 	}
@@ -160,6 +203,8 @@ void AEnemy::CombatSphereOnOverlapBegin(UPrimitiveComponent* OverlappedComponent
 void AEnemy::CombatSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
 	UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
 {
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_EnemyCombatSphereOverlap);
+
 	if(OtherActor && OtherComp)
 	{
 		AMain* Main = Cast<AMain>(OtherActor);
@@ -219,6 +264,8 @@ void AEnemy::MoveToTarget(AMain* Target)
 void AEnemy::CombatOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
 	UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_EnemyCombatOverlap);
+
 	if (OtherActor)
 	{
 		AMain* Main = Cast<AMain>(OtherActor);
@@ -231,8 +278,9 @@ void AEnemy::CombatOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor
 				{
 					FVector SocketLocation = TipSocket->GetSocketLocation(GetMesh());
 					
-					UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), Main->HitParticle, SocketLocation,
+					UParticleSystemComponent* Emitter = UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), Main->HitParticle, SocketLocation,
 					FRotator(0.f), false);
+					UPerformanceSubsystem::NotifyEmitterSpawned(this, Emitter);
 				}
 			}
 			if(Main->HitSound)
@@ -271,6 +319,8 @@ void AEnemy::DeactivateCollision()
 
 void AEnemy::Attack()
 {
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_EnemyAttack);
+
 	if (Alive() && bHasValidTarget)
 	{
 		if(AIController)
@@ -297,7 +347,7 @@ void AEnemy::AttackEnd()
 	bAttacking = false;
 	if (bOverlapCombatSphere)
 	{
-		float AttackTime = FMath::FRandRange(AttackMinTime, AttackMaxTime);
+		float AttackTime = UReplaySubsystem::GetWorldRandom(this, EGameplayRandom::AI).FRandRange(AttackMinTime, AttackMaxTime);
 		GetWorldTimerManager().SetTimer(AttackTimer, this, &AEnemy::Attack, AttackTime);
 	}
 }
@@ -327,6 +377,11 @@ void AEnemy::Die(AActor* Causer)
 		AnimInstance->Montage_JumpToSection(FName("Death"), CombatMontage);
 	}
 
+	const bool bWasAlive = Alive();
+	if (bWasAlive)
+	{
+		DEC_DWORD_STAT(STAT_LiveEnemies);
+	}
 	SetEnemyMovementStatus(EEnemyMovementStatus::EMS_Dead);
 
 	CombatCollision->SetCollisionEnabled(ECollisionEnabled::NoCollision);
@@ -341,6 +396,16 @@ void AEnemy::Die(AActor* Causer)
 	{
 		Main->UpdateCombatTarget();	
 	}
+
+	if (bWasAlive)
+	{
+		UWorldStateSubsystem::MarkConsumed(this, WorldStateId);
+	}
+
+	if (bWasAlive && bAutosaveOnDeath)
+	{
+		UAutosaveSubsystem::RequestAutosave(this, EAutosaveReason::BossKill);
+	}
 }
 
 void AEnemy::DeathEnd()
@@ -81,11 +81,21 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
 	float DeathDelay;
+
+	/** Autosave when this enemy dies, for bosses */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
+	bool bAutosaveOnDeath;
+
+	/** Stable id within the level, assigned when the level is saved in the editor. Spawned enemies have none */
+	UPROPERTY(VisibleAnywhere, Category = "Save", NonPIEDuplicateTransient)
+	int32 WorldStateId;
 	
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EnemyHealthBarWidget.h"
+#include "Enemy.h"
+
+float UEnemyHealthBarWidget::GetHealthPercent() const
+{
+	const AEnemy* AssignedEnemy = Enemy.Get();
+	if (!AssignedEnemy || AssignedEnemy->MaxHealth <= 0.f)
+	{
+		return 0.f;
+	}
+	return FMath::Clamp(AssignedEnemy->Health / AssignedEnemy->MaxHealth, 0.f, 1.f);
+}
+
+void UEnemyHealthBarWidget::SetEnemy(AEnemy* NewEnemy)
+{
+	if (Enemy.Get() != NewEnemy)
+	{
+		Enemy = NewEnemy;
+		OnEnemyAssigned();
+	}
+}
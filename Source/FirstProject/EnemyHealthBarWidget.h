@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "EnemyHealthBarWidget.generated.h"
+
+/**
+ * Optional parent for the enemy health bar widget.
+ * Pooled bars are handed from enemy to enemy, so the bar reads the enemy it is assigned to
+ * instead of the player's combat target.
+ */
+UCLASS()
+class FIRSTPROJECT_API UEnemyHealthBarWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+
+	UFUNCTION(BlueprintPure, Category = "HUD")
+	FORCEINLINE class AEnemy* GetEnemy() const { return Enemy.Get(); }
+
+	/** Enemy health over max health, zero when unassigned */
+	UFUNCTION(BlueprintPure, Category = "HUD")
+	float GetHealthPercent() const;
+
+	void SetEnemy(AEnemy* NewEnemy);
+
+	/** Called when the bar is taken from the pool for a different enemy */
+	UFUNCTION(BlueprintImplementableEvent, Category = "HUD")
+	void OnEnemyAssigned();
+
+private:
+
+	TWeakObjectPtr<AEnemy> Enemy;
+};
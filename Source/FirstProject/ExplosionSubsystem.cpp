@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ExplosionSubsystem.h"
+#include "FirstProject.h"
+#include "Explosive.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+UExplosionSubsystem::UExplosionSubsystem()
+{
+	MaxDetonationsPerFrame = 8;
+
+	BurstDetonations = 0;
+	BurstFrames = 0;
+	BurstPeakSeconds = 0.0;
+	BurstTotalSeconds = 0.0;
+}
+
+void UExplosionSubsystem::QueueDetonation(AExplosive* Explosive, float Delay)
+{
+	if (!Explosive || Explosive->bDetonationQueued || Explosive->bDetonated)
+	{
+		return;
+	}
+
+	Explosive->bDetonationQueued = true;
+
+	FPendingDetonation Detonation;
+	Detonation.Explosive = Explosive;
+	Detonation.TriggerTime = GetWorld()->GetTimeSeconds() + Delay;
+	Pending.Add(Detonation);
+}
+
+void UExplosionSubsystem::DetonateAll()
+{
+	for (TActorIterator<AExplosive> It(GetWorld()); It; ++It)
+	{
+		QueueDetonation(*It, 0.f);
+	}
+}
+
+void UExplosionSubsystem::Tick(float DeltaTime)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// Detonations only ever append to the queue, so walking it by index in order is safe
+	int32 Detonations = 0;
+	for (int32 Index = 0; Index < Pending.Num() && Detonations < MaxDetonationsPerFrame; )
+	{
+		if (Pending[Index].TriggerTime > Now)
+		{
+			++Index;
+			continue;
+		}
+
+		AExplosive* Explosive = Pending[Index].Explosive.Get();
+		Pending.RemoveAt(Index, 1, false);
+
+		if (Explosive && !Explosive->IsPendingKill())
+		{
+			Explosive->Detonate();
+			++Detonations;
+		}
+	}
+
+	const double FrameSeconds = FPlatformTime::Seconds() - StartTime;
+	BurstDetonations += Detonations;
+	++BurstFrames;
+	BurstPeakSeconds = FMath::Max(BurstPeakSeconds, FrameSeconds);
+	BurstTotalSeconds += FrameSeconds;
+
+	if (Pending.Num() == 0)
+	{
+		FIRSTPROJECT_HOT_LOG(Log, TEXT("Explosion burst: %d detonations over %d frames, peak %.3f ms, total %.3f ms"),
+			BurstDetonations, BurstFrames, BurstPeakSeconds * 1000.0, BurstTotalSeconds * 1000.0);
+
+		BurstDetonations = 0;
+		BurstFrames = 0;
+		BurstPeakSeconds = 0.0;
+		BurstTotalSeconds = 0.0;
+	}
+}
+
+bool UExplosionSubsystem::IsTickable() const
+{
+	return Pending.Num() > 0;
+}
+
+ETickableTickType UExplosionSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* UExplosionSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UExplosionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UExplosionSubsystem, STATGROUP_Tickables);
+}
+
+#if FIRSTPROJECT_DEBUG_TOOLS
+
+/** Benchmark helper: pair with FirstProject.SpawnPickupField to set off a whole field of explosives at once */
+static FAutoConsoleCommandWithWorld DetonateAllCommand(
+	TEXT("FirstProject.DetonateAll"),
+	TEXT("Queue every explosive in the world to detonate on the same frame, burst timings are logged when the queue drains"),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		UExplosionSubsystem* Explosions = World ? World->GetSubsystem<UExplosionSubsystem>() : nullptr;
+		if (Explosions)
+		{
+			Explosions->DetonateAll();
+		}
+	}));
+
+#endif
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "ExplosionSubsystem.generated.h"
+
+struct FPendingDetonation
+{
+	TWeakObjectPtr<class AExplosive> Explosive;
+
+	/** World time at which the explosive goes off */
+	float TriggerTime;
+};
+
+/**
+ * Queue of explosives waiting to go off.
+ * Chain reactions are queued here instead of detonating inside overlap callbacks,
+ * and only a fixed number of detonations run per frame.
+ */
+UCLASS()
+class FIRSTPROJECT_API UExplosionSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UExplosionSubsystem();
+
+	/** Detonate the explosive after Delay seconds, ignored if it is already queued */
+	void QueueDetonation(AExplosive* Explosive, float Delay);
+
+	/** Queue every explosive in the world to go off on the next tick */
+	void DetonateAll();
+
+	FORCEINLINE int32 GetNumPending() const { return Pending.Num(); }
+
+	/** Detonations allowed per frame, the rest wait for the next frame */
+	int32 MaxDetonationsPerFrame;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	TArray<FPendingDetonation> Pending;
+
+	/** Stats for the current burst, reported once the queue drains */
+	int32 BurstDetonations;
+	int32 BurstFrames;
+	double BurstPeakSeconds;
+	double BurstTotalSeconds;
+};
@@ -2,16 +2,28 @@
 
 
 #include "Explosive.h"
+#include "FirstProject.h"
+#include "PerformanceSubsystem.h"
 #include "Main.h"
 #include "Kismet/GameplayStatics.h"
 #include "Engine/World.h"
 #include "Sound/SoundCue.h"
 #include "Particles/ParticleSystemComponent.h"
 #include "Enemy.h"
+#include "ExplosionSubsystem.h"
+#include "WorldStateSubsystem.h"
+#include "CollisionQueryParams.h"
 
 AExplosive::AExplosive()
 {
 	Damage = 15.f;
+	DamageRadius = 300.f;
+	MinDamageFraction = 0.25f;
+	MaxOcclusionTraces = 16;
+	ChainDelay = 0.1f;
+
+	bDetonationQueued = false;
+	bDetonated = false;
 }
 
 void AExplosive::OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
@@ -25,19 +37,100 @@ void AExplosive::OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor
 		AEnemy* Enemy = Cast<AEnemy>(OtherActor);
 		if(Main || Enemy)
 		{
-			if(OverlapParticles)
+			// Don't detonate inside the overlap callback, the blast itself moves and destroys overlapping actors
+			UExplosionSubsystem* Explosions = GetWorld()->GetSubsystem<UExplosionSubsystem>();
+			if (Explosions)
+			{
+				Explosions->QueueDetonation(this, 0.f);
+			}
+		}
+	}
+}
+
+void AExplosive::Detonate()
+{
+	if (bDetonated)
+	{
+		return;
+	}
+	bDetonated = true;
+	UWorldStateSubsystem::MarkConsumed(this, WorldStateId);
+
+	UWorld* World = GetWorld();
+	const FVector Origin = GetActorLocation();
+
+	if(OverlapParticles)
+	{
+		UParticleSystemComponent* Emitter = UGameplayStatics::SpawnEmitterAtLocation(World, OverlapParticles, Origin, FRotator(0.f), true);
+		UPerformanceSubsystem::NotifyEmitterSpawned(this, Emitter);
+	}
+	if(OverlapSound)
+	{
+		UGameplayStatics::PlaySound2D(this, OverlapSound);
+	}
+
+	// One overlap query for the whole blast
+	TArray<FOverlapResult> Overlaps;
+	FCollisionObjectQueryParams ObjectParams;
+	ObjectParams.AddObjectTypesToQuery(ECollisionChannel::ECC_Pawn);
+	ObjectParams.AddObjectTypesToQuery(ECollisionChannel::ECC_WorldDynamic);
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ExplosiveDetonate), false, this);
+	World->OverlapMultiByObjectType(Overlaps, Origin, FQuat::Identity, ObjectParams,
+		FCollisionShape::MakeSphere(DamageRadius), QueryParams);
+
+	TSet<AActor*, DefaultKeyFuncs<AActor*>, TInlineSetAllocator<32>> Visited;
+	UExplosionSubsystem* Explosions = World->GetSubsystem<UExplosionSubsystem>();
+	int32 TracesLeft = MaxOcclusionTraces;
+
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		AActor* Target = Overlap.GetActor();
+		if (!Target || Target->IsPendingKill())
+		{
+			continue;
+		}
+
+		bool bAlreadyVisited = false;
+		Visited.Add(Target, &bAlreadyVisited);
+		if (bAlreadyVisited)
+		{
+			continue;
+		}
+
+		AExplosive* OtherExplosive = Cast<AExplosive>(Target);
+		if (OtherExplosive)
+		{
+			if (Explosions)
 			{
-				UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), OverlapParticles, GetActorLocation(), FRotator(0.f), true);
+				Explosions->QueueDetonation(OtherExplosive, ChainDelay);
 			}
-			if(OverlapSound)
+			continue;
+		}
+
+		if (!Cast<AMain>(Target) && !Cast<AEnemy>(Target))
+		{
+			continue;
+		}
+
+		const FVector TargetLocation = Target->GetActorLocation();
+		if (TracesLeft > 0)
+		{
+			--TracesLeft;
+
+			FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(ExplosiveOcclusion), false, this);
+			TraceParams.AddIgnoredActor(Target);
+			if (World->LineTraceTestByChannel(Origin, TargetLocation, ECollisionChannel::ECC_Visibility, TraceParams))
 			{
-				UGameplayStatics::PlaySound2D(this, OverlapSound);
+				continue;
 			}
-			
-			UGameplayStatics::ApplyDamage(OtherActor, Damage, nullptr, this, DamageTypeClass);
-			Destroy();
 		}
+
+		const float Alpha = FMath::Clamp(FVector::Dist(Origin, TargetLocation) / DamageRadius, 0.f, 1.f);
+		const float ScaledDamage = Damage * FMath::Lerp(1.f, MinDamageFraction, Alpha);
+		UGameplayStatics::ApplyDamage(Target, ScaledDamage, nullptr, this, DamageTypeClass);
 	}
+
+	Destroy();
 }
 
 void AExplosive::OnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
@@ -30,5 +30,28 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
 	TSubclassOf<UDamageType> DamageTypeClass;
+
+	/** Everything inside this radius is damaged and other explosives are set off */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Damage")
+	float DamageRadius;
+
+	/** Fraction of Damage dealt at the edge of the radius, full damage at the center */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Damage", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float MinDamageFraction;
+
+	/** Line of sight traces allowed per detonation, targets past the budget are treated as visible */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Damage")
+	int32 MaxOcclusionTraces;
+
+	/** Delay before a neighbouring explosive caught in the blast goes off */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Damage")
+	float ChainDelay;
+
+	bool bDetonationQueued;
+
+	bool bDetonated;
+
+	/** Play effects, damage everything in range, queue nearby explosives and destroy this one */
+	void Detonate();
 	
 };
@@ -10,7 +10,13 @@ public class FirstProject : ModuleRules
 	
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "UMG" , "AIModule", "ApplicationCore"});
 
-		PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore"  });
+		PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore", "Json" });
+
+		// Editor delegates for assigning world state ids when levels are saved
+		if (Target.bBuildEditor)
+		{
+			PrivateDependencyModuleNames.Add("UnrealEd");
+		}
 
 		// Uncomment if you are using Slate UI
 		// PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
@@ -2,5 +2,105 @@
 
 #include "FirstProject.h"
 #include "Modules/ModuleManager.h"
+#include "WorldStateSubsystem.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, FirstProject, "FirstProject" );
+#if WITH_EDITOR
+#include "Editor.h"
+#endif
+
+DECLARE_LLM_MEMORY_STAT(TEXT("Enemies"), STAT_EnemiesLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("Items"), STAT_ItemsLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("Weapons"), STAT_WeaponsLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("SaveData"), STAT_SaveDataLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("HUDWidgets"), STAT_HUDWidgetsLLM, STATGROUP_LLMFULL);
+
+DECLARE_LLM_MEMORY_STAT(TEXT("Enemies"), STAT_EnemiesSummaryLLM, STATGROUP_LLM);
+DECLARE_LLM_MEMORY_STAT(TEXT("Items"), STAT_ItemsSummaryLLM, STATGROUP_LLM);
+DECLARE_LLM_MEMORY_STAT(TEXT("Weapons"), STAT_WeaponsSummaryLLM, STATGROUP_LLM);
+DECLARE_LLM_MEMORY_STAT(TEXT("SaveData"), STAT_SaveDataSummaryLLM, STATGROUP_LLM);
+DECLARE_LLM_MEMORY_STAT(TEXT("HUDWidgets"), STAT_HUDWidgetsSummaryLLM, STATGROUP_LLM);
+
+class FFirstProjectModule : public FDefaultGameModuleImpl
+{
+public:
+
+	virtual void StartupModule() override
+	{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+		FLowLevelMemTracker& Tracker = FLowLevelMemTracker::Get();
+		Tracker.RegisterProjectTag((int32)EFirstProjectLLMTag::Enemies, TEXT("Enemies"), GET_STATFNAME(STAT_EnemiesLLM), GET_STATFNAME(STAT_EnemiesSummaryLLM));
+		Tracker.RegisterProjectTag((int32)EFirstProjectLLMTag::Items, TEXT("Items"), GET_STATFNAME(STAT_ItemsLLM), GET_STATFNAME(STAT_ItemsSummaryLLM));
+		Tracker.RegisterProjectTag((int32)EFirstProjectLLMTag::Weapons, TEXT("Weapons"), GET_STATFNAME(STAT_WeaponsLLM), GET_STATFNAME(STAT_WeaponsSummaryLLM));
+		Tracker.RegisterProjectTag((int32)EFirstProjectLLMTag::SaveData, TEXT("SaveData"), GET_STATFNAME(STAT_SaveDataLLM), GET_STATFNAME(STAT_SaveDataSummaryLLM));
+		Tracker.RegisterProjectTag((int32)EFirstProjectLLMTag::HUDWidgets, TEXT("HUDWidgets"), GET_STATFNAME(STAT_HUDWidgetsLLM), GET_STATFNAME(STAT_HUDWidgetsSummaryLLM));
+#endif
+
+#if WITH_EDITOR
+		PreSaveWorldHandle = FEditorDelegates::PreSaveWorld.AddStatic(&UWorldStateSubsystem::OnPreSaveWorld);
+#endif
+	}
+
+	virtual void ShutdownModule() override
+	{
+#if WITH_EDITOR
+		FEditorDelegates::PreSaveWorld.Remove(PreSaveWorldHandle);
+#endif
+	}
+
+private:
+
+#if WITH_EDITOR
+	FDelegateHandle PreSaveWorldHandle;
+#endif
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FFirstProjectModule, FirstProject, "FirstProject" );
+
+DEFINE_LOG_CATEGORY(LogFirstProject);
+
+CSV_DEFINE_CATEGORY_MODULE(FIRSTPROJECT_API, FirstProject, true);
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER && FIRSTPROJECT_DEBUG_TOOLS
+
+static TAutoConsoleVariable<float> CVarEnemiesBudget(TEXT("FirstProject.MemBudget.Enemies"), 64.f, TEXT("Memory budget for enemies in MB, 0 for none"));
+static TAutoConsoleVariable<float> CVarItemsBudget(TEXT("FirstProject.MemBudget.Items"), 32.f, TEXT("Memory budget for items and pickups in MB, 0 for none"));
+static TAutoConsoleVariable<float> CVarWeaponsBudget(TEXT("FirstProject.MemBudget.Weapons"), 16.f, TEXT("Memory budget for weapons in MB, 0 for none"));
+static TAutoConsoleVariable<float> CVarSaveDataBudget(TEXT("FirstProject.MemBudget.SaveData"), 4.f, TEXT("Memory budget for save data in MB, 0 for none"));
+static TAutoConsoleVariable<float> CVarHUDWidgetsBudget(TEXT("FirstProject.MemBudget.HUDWidgets"), 32.f, TEXT("Memory budget for HUD widgets in MB, 0 for none"));
+
+/** Needs -llm on the command line, the tracker is off otherwise */
+static FAutoConsoleCommand MemReportCommand(
+	TEXT("FirstProject.MemReport"),
+	TEXT("Log the memory tracked for each gameplay system against its FirstProject.MemBudget.* budget"),
+	FConsoleCommandDelegate::CreateStatic([]()
+	{
+		const struct
+		{
+			EFirstProjectLLMTag Tag;
+			const TCHAR* Name;
+			TAutoConsoleVariable<float>* Budget;
+		} Systems[] =
+		{
+			{ EFirstProjectLLMTag::Enemies, TEXT("Enemies"), &CVarEnemiesBudget },
+			{ EFirstProjectLLMTag::Items, TEXT("Items"), &CVarItemsBudget },
+			{ EFirstProjectLLMTag::Weapons, TEXT("Weapons"), &CVarWeaponsBudget },
+			{ EFirstProjectLLMTag::SaveData, TEXT("SaveData"), &CVarSaveDataBudget },
+			{ EFirstProjectLLMTag::HUDWidgets, TEXT("HUDWidgets"), &CVarHUDWidgetsBudget },
+		};
+
+		for (const auto& System : Systems)
+		{
+			const float Megabytes = FLowLevelMemTracker::Get().GetTagAmountForTracker(ELLMTracker::Default, (ELLMTag)System.Tag) / (1024.f * 1024.f);
+			const float Budget = System.Budget->GetValueOnGameThread();
+			if (Budget > 0.f && Megabytes > Budget)
+			{
+				UE_LOG(LogFirstProject, Warning, TEXT("%-10s %8.2f MB, over its %.2f MB budget"), System.Name, Megabytes, Budget);
+			}
+			else
+			{
+				UE_LOG(LogFirstProject, Log, TEXT("%-10s %8.2f MB"), System.Name, Megabytes);
+			}
+		}
+	}));
+
+#endif
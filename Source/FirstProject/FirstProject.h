@@ -3,4 +3,41 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "HAL/LowLevelMemTracker.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogFirstProject, Log, All);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(FIRSTPROJECT_API, FirstProject);
+
+DECLARE_STATS_GROUP(TEXT("FirstProject"), STATGROUP_FirstProject, STATCAT_Advanced);
+
+/** Low level memory tracker tags for gameplay systems, in the project range of ELLMTag. See stat LLM, -llmcsv and FirstProject.MemReport */
+enum class EFirstProjectLLMTag : uint8
+{
+	Enemies = (uint8)ELLMTag::ProjectTagStart,
+	Items,
+	Weapons,
+	SaveData,
+	HUDWidgets,
+
+	End
+};
+
+/** Attribute allocations in the enclosing scope to a gameplay system */
+#define FIRSTPROJECT_LLM_SCOPE(Tag) LLM_SCOPE((ELLMTag)(Tag))
+
+/** Times the enclosing scope for stat FirstProject and marks it as a named CPU scope in Insights captures */
+#define FIRSTPROJECT_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Stat)
+
+/** Debug logging, drawing and console commands, compiled out of Shipping and Test builds */
+#define FIRSTPROJECT_DEBUG_TOOLS !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
+
+#if FIRSTPROJECT_DEBUG_TOOLS
+	#define FIRSTPROJECT_HOT_LOG(Verbosity, Format, ...) UE_LOG(LogFirstProject, Verbosity, Format, ##__VA_ARGS__)
+#else
+	#define FIRSTPROJECT_HOT_LOG(Verbosity, Format, ...)
+#endif
@@ -2,6 +2,52 @@
 
 
 #include "FirstSaveGame.h"
+#include "FirstProject.h"
+#include "HAL/FileManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/NameAsStringProxyArchive.h"
+
+DECLARE_CYCLE_STAT(TEXT("Save Write"), STAT_SaveWrite, STATGROUP_FirstProject);
+
+namespace SaveFormat
+{
+	const uint32 Magic = 0x46505356; // "FPSV"
+
+	/** Bumped when the header changes, FSaveGameData fields are versioned by tagged properties */
+	const int32 Version = 1;
+
+	const TCHAR* const TempSuffix = TEXT(".tmp");
+
+	const TCHAR* const SlotExtension = TEXT(".fpsave");
+
+	const uint32 IndexMagic = 0x46505349; // "FPSI"
+
+	const int32 IndexVersion = 1;
+
+	/** Guards the cached index. Never held across disk I/O, so listing slots doesn't wait on a background write */
+	FCriticalSection IndexLock;
+
+	/** Slot writes run on the thread pool, their index file writes must not interleave */
+	FCriticalSection IndexFileLock;
+
+	/** Slot index as last written, read from disk on first use */
+	TOptional<FSaveSlotIndex> CachedIndex;
+
+	/** Bumped on every change of the cached index, so a slower write of an older copy can't replace a newer file */
+	uint32 IndexRevision = 0;
+	uint32 WrittenIndexRevision = 0;
+
+	FString GetDirectory()
+	{
+		return FPaths::ProjectSavedDir() / TEXT("SaveGames");
+	}
+}
 
 UFirstSaveGame::UFirstSaveGame()
 {
@@ -10,3 +56,325 @@ UFirstSaveGame::UFirstSaveGame()
 	CharacterStats.WeaponName = TEXT("");
 	CharacterStats.LevelName = TEXT("");
 }
+
+bool UFirstSaveGame::WriteSlot(const FSaveGameData& Data, const FString& SlotName, int32 SlotUserIndex)
+{
+	// Runs on the thread pool for autosaves, where the caller's scope doesn't reach
+	FIRSTPROJECT_LLM_SCOPE(EFirstProjectLLMTag::SaveData);
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_SaveWrite);
+	CSV_SCOPED_TIMING_STAT(FirstProject, SaveWrite);
+
+	if (!IsValidSlotName(SlotName))
+	{
+		return false;
+	}
+
+	TArray<uint8> Serialized;
+	FMemoryWriter Writer(Serialized, true);
+	FNameAsStringProxyArchive Archive(Writer);
+	FSaveGameData::StaticStruct()->SerializeItem(Archive, const_cast<FSaveGameData*>(&Data), nullptr);
+
+	const int32 UncompressedSize = Serialized.Num();
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, UncompressedSize);
+
+	TArray<uint8> File;
+	FMemoryWriter FileWriter(File);
+	uint32 Magic = SaveFormat::Magic;
+	int32 Version = SaveFormat::Version;
+	int32 PackageVersion = Writer.UE4Ver();
+	int32 Size = UncompressedSize;
+	FileWriter << Magic << Version << PackageVersion << Size;
+
+	const int32 HeaderSize = File.Num();
+	File.AddUninitialized(CompressedSize);
+	if (!FCompression::CompressMemory(NAME_Zlib, File.GetData() + HeaderSize, CompressedSize, Serialized.GetData(), UncompressedSize))
+	{
+		return false;
+	}
+	File.SetNum(HeaderSize + CompressedSize);
+
+	// Readers never see a half written slot, at worst the previous one or the finished temporary
+	const FString Path = GetSlotPath(SlotName, SlotUserIndex);
+	const FString TempPath = Path + SaveFormat::TempSuffix;
+	if (!FFileHelper::SaveArrayToFile(File, *TempPath) || !IFileManager::Get().Move(*Path, *TempPath, true, true))
+	{
+		return false;
+	}
+
+	FSaveSlotInfo Info;
+	Info.SlotName = SlotName;
+	Info.LevelName = Data.CharacterStats.LevelName;
+	Info.Coins = Data.CharacterStats.Coins;
+	Info.PlayTime = Data.PlayTime;
+	Info.Timestamp = FDateTime::UtcNow();
+	Info.Version = SaveFormat::Version;
+
+	return UpdateIndex([&Info](FSaveSlotIndex& Index)
+	{
+		Index.Slots.RemoveAll([&Info](const FSaveSlotInfo& Slot) { return Slot.SlotName == Info.SlotName; });
+		Index.Slots.Insert(Info, 0);
+	});
+}
+
+bool UFirstSaveGame::ReadSlot(const FString& SlotName, int32 SlotUserIndex, FSaveGameData& OutData)
+{
+	FString Path = GetSlotPath(SlotName, SlotUserIndex);
+	if (!IFileManager::Get().FileExists(*Path))
+	{
+		Path += SaveFormat::TempSuffix;
+	}
+	if (!IFileManager::Get().FileExists(*Path))
+	{
+		UFirstSaveGame* Legacy = Cast<UFirstSaveGame>(UGameplayStatics::LoadGameFromSlot(SlotName, SlotUserIndex));
+		if (Legacy)
+		{
+			OutData.CharacterStats = Legacy->CharacterStats;
+			return true;
+		}
+		return false;
+	}
+
+	return ReadSlotFile(Path, OutData);
+}
+
+TArray<FSaveSlotInfo> UFirstSaveGame::ListSlots()
+{
+	LoadCachedIndex();
+
+	FScopeLock Lock(&SaveFormat::IndexLock);
+	return SaveFormat::CachedIndex->Slots;
+}
+
+bool UFirstSaveGame::DeleteSlot(const FString& SlotName, int32 SlotUserIndex)
+{
+	if (!IsValidSlotName(SlotName))
+	{
+		return false;
+	}
+
+	const FString Path = GetSlotPath(SlotName, SlotUserIndex);
+	IFileManager::Get().Delete(*(Path + SaveFormat::TempSuffix), false, false, true);
+	const bool bDeleted = IFileManager::Get().Delete(*Path, false, false, true);
+	// Otherwise ReadSlot would fall back to it
+	UGameplayStatics::DeleteGameInSlot(SlotName, SlotUserIndex);
+
+	const bool bIndexSaved = UpdateIndex([&SlotName](FSaveSlotIndex& Index)
+	{
+		Index.Slots.RemoveAll([&SlotName](const FSaveSlotInfo& Slot) { return Slot.SlotName == SlotName; });
+	});
+	return bIndexSaved && bDeleted;
+}
+
+bool UFirstSaveGame::ReadSlotFile(const FString& Path, FSaveGameData& OutData)
+{
+	TArray<uint8> File;
+	if (!FFileHelper::LoadFileToArray(File, *Path, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader FileReader(File);
+	uint32 Magic = 0;
+	int32 Version = 0;
+	int32 PackageVersion = 0;
+	int32 UncompressedSize = 0;
+	FileReader << Magic << Version << PackageVersion << UncompressedSize;
+	if (Magic != SaveFormat::Magic || Version > SaveFormat::Version || UncompressedSize <= 0)
+	{
+		UE_LOG(LogFirstProject, Warning, TEXT("Save slot %s is not a save file this build can read"), *Path);
+		return false;
+	}
+
+	TArray<uint8> Serialized;
+	Serialized.SetNumUninitialized(UncompressedSize);
+	const int32 HeaderSize = FileReader.Tell();
+	if (!FCompression::UncompressMemory(NAME_Zlib, Serialized.GetData(), UncompressedSize, File.GetData() + HeaderSize, File.Num() - HeaderSize))
+	{
+		UE_LOG(LogFirstProject, Warning, TEXT("Save slot %s is corrupt"), *Path);
+		return false;
+	}
+
+	FMemoryReader Reader(Serialized, true);
+	Reader.SetUE4Ver(PackageVersion);
+	FNameAsStringProxyArchive Archive(Reader);
+	FSaveGameData::StaticStruct()->SerializeItem(Archive, &OutData, nullptr);
+	return !Reader.IsError();
+}
+
+bool UFirstSaveGame::IsValidSlotName(const FString& SlotName)
+{
+	return !SlotName.IsEmpty()
+		&& !SlotName.Contains(TEXT("/")) && !SlotName.Contains(TEXT("\\"))
+		&& FPaths::MakeValidFileName(SlotName) == SlotName
+		&& FPaths::ValidatePath(SlotName);
+}
+
+FString UFirstSaveGame::GetSlotPath(const FString& SlotName, int32 SlotUserIndex)
+{
+	// Desktop save games ignore the user index too
+	return SaveFormat::GetDirectory() / SlotName + SaveFormat::SlotExtension;
+}
+
+FString UFirstSaveGame::GetIndexPath()
+{
+	return SaveFormat::GetDirectory() / TEXT("SlotIndex.fpindex");
+}
+
+void UFirstSaveGame::LoadCachedIndex()
+{
+	{
+		FScopeLock Lock(&SaveFormat::IndexLock);
+		if (SaveFormat::CachedIndex.IsSet())
+		{
+			return;
+		}
+	}
+
+	bool bNeedsSave = false;
+	FSaveSlotIndex Index = LoadIndex(bNeedsSave);
+
+	uint32 Revision = 0;
+	{
+		FScopeLock Lock(&SaveFormat::IndexLock);
+		// Another thread may have loaded it meanwhile, and changed it since
+		if (SaveFormat::CachedIndex.IsSet())
+		{
+			return;
+		}
+		SaveFormat::CachedIndex = Index;
+		Revision = ++SaveFormat::IndexRevision;
+	}
+
+	if (bNeedsSave)
+	{
+		SaveIndex(Index, Revision);
+	}
+}
+
+bool UFirstSaveGame::UpdateIndex(TFunctionRef<void(FSaveSlotIndex&)> Update)
+{
+	LoadCachedIndex();
+
+	FSaveSlotIndex Index;
+	uint32 Revision = 0;
+	{
+		FScopeLock Lock(&SaveFormat::IndexLock);
+		Update(SaveFormat::CachedIndex.GetValue());
+		Index = SaveFormat::CachedIndex.GetValue();
+		Revision = ++SaveFormat::IndexRevision;
+	}
+	return SaveIndex(Index, Revision);
+}
+
+FSaveSlotIndex UFirstSaveGame::LoadIndex(bool& bOutNeedsSave)
+{
+	const FString Path = GetIndexPath();
+
+	FSaveSlotIndex Index;
+	bOutNeedsSave = false;
+	if (ReadIndexFile(Path, Index))
+	{
+		return Index;
+	}
+
+	// Replacing the index deletes it before the rename, a crash in between leaves only the temporary
+	bOutNeedsSave = true;
+	Index = FSaveSlotIndex();
+	if (ReadIndexFile(Path + SaveFormat::TempSuffix, Index))
+	{
+		UE_LOG(LogFirstProject, Log, TEXT("Recovered the save slot index from its temporary file"));
+		return Index;
+	}
+
+	UE_LOG(LogFirstProject, Log, TEXT("Rebuilding the save slot index from the slots"));
+	return RebuildIndex();
+}
+
+bool UFirstSaveGame::ReadIndexFile(const FString& Path, FSaveSlotIndex& OutIndex)
+{
+	TArray<uint8> File;
+	if (!FFileHelper::LoadFileToArray(File, *Path, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(File, true);
+	uint32 Magic = 0;
+	int32 Version = 0;
+	int32 PackageVersion = 0;
+	Reader << Magic << Version << PackageVersion;
+	if (Magic != SaveFormat::IndexMagic || Version > SaveFormat::IndexVersion)
+	{
+		UE_LOG(LogFirstProject, Warning, TEXT("Save slot index %s is not one this build can read"), *Path);
+		return false;
+	}
+
+	Reader.SetUE4Ver(PackageVersion);
+	FNameAsStringProxyArchive Archive(Reader);
+	FSaveSlotIndex::StaticStruct()->SerializeItem(Archive, &OutIndex, nullptr);
+	if (Reader.IsError())
+	{
+		UE_LOG(LogFirstProject, Warning, TEXT("Save slot index %s is corrupt"), *Path);
+		return false;
+	}
+	return true;
+}
+
+bool UFirstSaveGame::SaveIndex(const FSaveSlotIndex& Index, uint32 Revision)
+{
+	TArray<uint8> File;
+	FMemoryWriter Writer(File, true);
+	uint32 Magic = SaveFormat::IndexMagic;
+	int32 Version = SaveFormat::IndexVersion;
+	int32 PackageVersion = Writer.UE4Ver();
+	Writer << Magic << Version << PackageVersion;
+
+	FNameAsStringProxyArchive Archive(Writer);
+	FSaveSlotIndex::StaticStruct()->SerializeItem(Archive, const_cast<FSaveSlotIndex*>(&Index), nullptr);
+
+	FScopeLock Lock(&SaveFormat::IndexFileLock);
+	if (Revision <= SaveFormat::WrittenIndexRevision)
+	{
+		// A newer copy is on disk already
+		return true;
+	}
+
+	// Same rename as the slots, a crash mid write leaves the old index or the finished temporary
+	const FString Path = GetIndexPath();
+	const FString TempPath = Path + SaveFormat::TempSuffix;
+	if (!FFileHelper::SaveArrayToFile(File, *TempPath) || !IFileManager::Get().Move(*Path, *TempPath, true, true))
+	{
+		return false;
+	}
+	SaveFormat::WrittenIndexRevision = Revision;
+	return true;
+}
+
+FSaveSlotIndex UFirstSaveGame::RebuildIndex()
+{
+	const FString Directory = SaveFormat::GetDirectory();
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *(Directory / TEXT("*") + SaveFormat::SlotExtension), true, false);
+
+	FSaveSlotIndex Index;
+	for (const FString& File : Files)
+	{
+		const FString Path = Directory / File;
+		FSaveGameData Data;
+		if (!ReadSlotFile(Path, Data))
+		{
+			continue;
+		}
+
+		FSaveSlotInfo& Info = Index.Slots.AddDefaulted_GetRef();
+		Info.SlotName = FPaths::GetBaseFilename(File);
+		Info.LevelName = Data.CharacterStats.LevelName;
+		Info.Coins = Data.CharacterStats.Coins;
+		Info.PlayTime = Data.PlayTime;
+		Info.Timestamp = IFileManager::Get().GetTimeStamp(*Path);
+		Info.Version = SaveFormat::Version;
+	}
+
+	Index.Slots.Sort([](const FSaveSlotInfo& A, const FSaveSlotInfo& B) { return A.Timestamp > B.Timestamp; });
+	return Index;
+}
@@ -40,8 +40,89 @@ struct FCharacterStats
 	
 };
 
+/** Placed actors of one level that are gone for good */
+USTRUCT()
+struct FLevelWorldState
+{
+	GENERATED_BODY()
+
+	/** Bit per WorldStateId, set once the actor was collected, detonated or killed */
+	UPROPERTY()
+	TArray<uint32> ConsumedBits;
+};
+
+/** Contents of a save slot. Copied from the game on the game thread, serialized and written on a worker */
+USTRUCT()
+struct FSaveGameData
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FCharacterStats CharacterStats;
+
+	/** Keyed by level package name */
+	UPROPERTY()
+	TMap<FString, FLevelWorldState> LevelStates;
+
+	/** Seconds played, over all sessions */
+	UPROPERTY()
+	float PlayTime;
+
+	FSaveGameData()
+		: PlayTime(0.f)
+	{
+	}
+};
+
+/** What a save menu shows for a slot, kept in the slot index so listing never opens the slots themselves */
+USTRUCT(BlueprintType)
+struct FSaveSlotInfo
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "SaveData")
+	FString SlotName;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SaveData")
+	FString LevelName;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SaveData")
+	int32 Coins;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SaveData")
+	float PlayTime;
+
+	/** When the slot was last written, UTC */
+	UPROPERTY(BlueprintReadOnly, Category = "SaveData")
+	FDateTime Timestamp;
+
+	/** Save format version the slot was written with */
+	UPROPERTY(BlueprintReadOnly, Category = "SaveData")
+	int32 Version;
+
+	FSaveSlotInfo()
+		: Coins(0)
+		, PlayTime(0.f)
+		, Version(0)
+	{
+	}
+};
+
+USTRUCT()
+struct FSaveSlotIndex
+{
+	GENERATED_BODY()
+
+	/** Most recently written first */
+	UPROPERTY()
+	TArray<FSaveSlotInfo> Slots;
+};
+
 /**
- * 
+ * Default slot and the save file format.
+ * Slots are FSaveGameData serialized with tagged properties, so fields can be added without breaking old saves,
+ * then zlib compressed behind a small header. Slots written by the old SaveGameToSlot path are still read.
+ * Every write also updates the slot index, a small uncompressed file with one FSaveSlotInfo per slot.
  */
 UCLASS()
 class FIRSTPROJECT_API UFirstSaveGame : public USaveGame
@@ -61,8 +142,52 @@ public:
 	UPROPERTY(VisibleAnywhere, Category = "Basic")
 	FCharacterStats CharacterStats;
 
-	
+	/**
+	 * Serialize, compress and write Data to a temporary file, then rename it over the slot.
+	 * The slot's index entry is replaced the same way afterwards. Safe off the game thread
+	 */
+	static bool WriteSlot(const FSaveGameData& Data, const FString& SlotName, int32 SlotUserIndex);
 
-	
-	
+	/** Read a slot written by WriteSlot, or a legacy SaveGameToSlot save. Game thread only */
+	static bool ReadSlot(const FString& SlotName, int32 SlotUserIndex, FSaveGameData& OutData);
+
+	/**
+	 * Metadata of every slot, most recent first. Served from memory once the index has been read,
+	 * which falls back to the index's temporary file and then to rebuilding it from the slots
+	 */
+	UFUNCTION(BlueprintCallable, Category = "SaveData")
+	static TArray<FSaveSlotInfo> ListSlots();
+
+	/** Delete a slot and its index entry */
+	UFUNCTION(BlueprintCallable, Category = "SaveData")
+	static bool DeleteSlot(const FString& SlotName, int32 SlotUserIndex);
+
+	/** Slot names become file names in the save directory, so they can't hold path separators or characters file names can't */
+	static bool IsValidSlotName(const FString& SlotName);
+
+	static FString GetSlotPath(const FString& SlotName, int32 SlotUserIndex);
+
+	static FString GetIndexPath();
+
+private:
+
+	/** Read a slot in the WriteSlot format. Safe off the game thread */
+	static bool ReadSlotFile(const FString& Path, FSaveGameData& OutData);
+
+	/** Read the index into memory on first use, writing it back if it had to be recovered or rebuilt */
+	static void LoadCachedIndex();
+
+	/** Apply Update to the cached index and write the result. The index lock is only held for the update and the copy */
+	static bool UpdateIndex(TFunctionRef<void(FSaveSlotIndex&)> Update);
+
+	/** The index file, else its temporary, else one rebuilt from the slots. bOutNeedsSave is set unless the index file was read */
+	static FSaveSlotIndex LoadIndex(bool& bOutNeedsSave);
+
+	static bool ReadIndexFile(const FString& Path, FSaveSlotIndex& OutIndex);
+
+	/** Write Index unless a later revision is on disk already */
+	static bool SaveIndex(const FSaveSlotIndex& Index, uint32 Revision);
+
+	/** Index entries for the slot files on disk, for when the index itself is gone */
+	static FSaveSlotIndex RebuildIndex();
 };
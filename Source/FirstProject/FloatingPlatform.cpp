@@ -3,21 +3,31 @@
 
 #include "FloatingPlatform.h"
 #include "Components/StaticMeshComponent.h"
+#include "Curves/CurveFloat.h"
+#include "PlatformSubsystem.h"
+#include "Engine/World.h"
 
 // Sets default values
 AFloatingPlatform::AFloatingPlatform()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// Moved by UPlatformSubsystem while on a leg, never ticks itself
+	PrimaryActorTick.bCanEverTick = false;
 
 	Mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
 	RootComponent = Mesh;
+	Mesh->SetMobility(EComponentMobility::Movable);
 
 	StartPoint = FVector(0.f);
 	EndPoint = FVector(0.f);
 	InterpSpeed = 4.0f;
 	bInterping = false;
 	InterpTime = 1.f;
+	TravelTime = 2.f;
+	TimeOffset = 0.f;
+	EaseCurve = nullptr;
+
+	CycleStartTime = 0.f;
+	NextMoveTime = 0.f;
 }
 
 // Called when the game starts or when spawned
@@ -30,42 +40,57 @@ void AFloatingPlatform::BeginPlay()
 	EndPoint += StartPoint;
 	
 	bInterping = false;
-	GetWorldTimerManager().SetTimer(InterTimer, this, &AFloatingPlatform::ToggleInterping, InterpTime);
+	CycleStartTime = GetWorld()->GetTimeSeconds() - TimeOffset;
+	NextMoveTime = CycleStartTime;
 
-	Distance = FVector(EndPoint - StartPoint).Size();
+	UPlatformSubsystem* Platforms = GetWorld()->GetSubsystem<UPlatformSubsystem>();
+	if (Platforms)
+	{
+		Platforms->RegisterPlatform(this);
+	}
 }
 
-// Called every frame
-void AFloatingPlatform::Tick(float DeltaTime)
+void AFloatingPlatform::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
-
-	if (bInterping)
+	UPlatformSubsystem* Platforms = GetWorld()->GetSubsystem<UPlatformSubsystem>();
+	if (Platforms)
 	{
-		FVector CurrentLocation = GetActorLocation();
-		FVector Interp = FMath::VInterpTo(CurrentLocation, EndPoint, DeltaTime, InterpSpeed);
-		SetActorLocation(Interp);
-
-		float DistanceTraveled = (GetActorLocation() - StartPoint).Size();
-		if(Distance - DistanceTraveled <= 1.f)
-		{
-			ToggleInterping();
-
-			GetWorldTimerManager().SetTimer(InterTimer, this, &AFloatingPlatform::ToggleInterping, InterpTime);
-			SwapVectors(StartPoint, EndPoint);
-		}
+		Platforms->UnregisterPlatform(this);
 	}
-}
 
-void AFloatingPlatform::ToggleInterping()
-{
-	bInterping = !bInterping;
+	Super::EndPlay(EndPlayReason);
 }
 
-void AFloatingPlatform::SwapVectors(FVector& Vec1, FVector& Vec2)
+FVector AFloatingPlatform::GetLocationAtTime(float Time, bool& bOutMoving, float& OutPhaseEnd) const
 {
-	FVector Temp = Vec1;
-	Vec1 = Vec2;
-	Vec2 = Temp;
-}
+	// Cycle: rest at start, leg out, rest at end, leg back
+	const float Rest = FMath::Max(InterpTime, 0.f);
+	const float Leg = FMath::Max(TravelTime, KINDA_SMALL_NUMBER);
+	const float Period = 2.f * (Rest + Leg);
+
+	const float CycleTime = FMath::Max(Time - CycleStartTime, 0.f);
+	const float T = FMath::Fmod(CycleTime, Period);
+	const float PeriodStart = Time - T;
 
+	if (T < Rest)
+	{
+		bOutMoving = false;
+		OutPhaseEnd = PeriodStart + Rest;
+		return StartPoint;
+	}
+	if (T >= Rest + Leg && T < 2.f * Rest + Leg)
+	{
+		bOutMoving = false;
+		OutPhaseEnd = PeriodStart + 2.f * Rest + Leg;
+		return EndPoint;
+	}
+
+	const bool bOutbound = T < Rest + Leg;
+	const float LegStart = bOutbound ? Rest : 2.f * Rest + Leg;
+	const float Alpha = (T - LegStart) / Leg;
+	const float Eased = EaseCurve ? EaseCurve->GetFloatValue(Alpha) : FMath::InterpEaseInOut(0.f, 1.f, Alpha, 2.f);
+
+	bOutMoving = true;
+	OutPhaseEnd = PeriodStart + LegStart + Leg;
+	return bOutbound ? FMath::Lerp(StartPoint, EndPoint, Eased) : FMath::Lerp(EndPoint, StartPoint, Eased);
+}
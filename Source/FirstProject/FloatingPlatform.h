@@ -24,30 +24,47 @@ public:
 	UPROPERTY(EditAnywhere, meta = (MakeEditWidget = "true"))
 	FVector EndPoint;
 
+	/** Not used by the time based mover, kept for existing Blueprints */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Platform")
 	float InterpSpeed;
 
+	/** Seconds the platform waits at each end */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Platform")
 	float InterpTime;
 
-	FTimerHandle InterTimer;
+	/** Seconds one leg from one end to the other takes */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Platform")
+	float TravelTime;
+
+	/** Shifts the cycle so platforms placed together don't move in lockstep */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Platform")
+	float TimeOffset;
 
+	/** Maps leg progress 0..1 to distance 0..1, ease in/out when not set */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Platform")
+	class UCurveFloat* EaseCurve;
+
+	/** True while the platform is on one of its legs */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Platform")
 	bool bInterping;
 
-	float Distance;
-	
+	/** World time the cycle is measured from */
+	float CycleStartTime;
+
+	/** While resting, the world time the next leg starts */
+	float NextMoveTime;
+
+	/**
+	 * Platform location at a world time, a pure function of time.
+	 * @param bOutMoving set when the platform is on a leg at that time
+	 * @param OutPhaseEnd world time the current leg or rest ends
+	 */
+	FVector GetLocationAtTime(float Time, bool& bOutMoving, float& OutPhaseEnd) const;
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
-	void ToggleInterping();
-
-	void SwapVectors(FVector& Vec1, FVector& Vec2);
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 };
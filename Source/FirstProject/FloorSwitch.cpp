@@ -2,15 +2,17 @@
 
 
 #include "FloorSwitch.h"
+#include "FirstProject.h"
 #include "Components/BoxComponent.h"
 #include "Components/StaticMeshComponent.h"
+#include "CurveActuatorComponent.h"
 
 
 // Sets default values
 AFloorSwitch::AFloorSwitch()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
 
 	TriggerBox = CreateDefaultSubobject<UBoxComponent>(TEXT("TriggerBox"));
 	RootComponent = TriggerBox;
@@ -28,6 +30,9 @@ AFloorSwitch::AFloorSwitch()
 	Door = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Door"));
 	Door->SetupAttachment(GetRootComponent());
 
+	DoorActuator = CreateDefaultSubobject<UCurveActuatorComponent>(TEXT("DoorActuator"));
+	SwitchActuator = CreateDefaultSubobject<UCurveActuatorComponent>(TEXT("SwitchActuator"));
+
 	SwitchTime = 2.f;
 
 	bCharacterOnSwitch = false;
@@ -38,8 +43,23 @@ void AFloorSwitch::CloseDoor()
 {
 	if(!bCharacterOnSwitch)
 	{
-		LowerDoor();
-		RaiseFloorSwitch();
+		if (DoorActuator->Curve)
+		{
+			DoorActuator->Reverse();
+		}
+		else
+		{
+			LowerDoor();
+		}
+
+		if (SwitchActuator->Curve)
+		{
+			SwitchActuator->Reverse();
+		}
+		else
+		{
+			RaiseFloorSwitch();
+		}
 	}
 	
 }
@@ -54,34 +74,58 @@ void AFloorSwitch::BeginPlay()
 
 	InitialDoorLocation = Door->GetComponentLocation();
 	InitialSwitchLocation = FloorSwitch->GetComponentLocation();
-	
-}
-
-// Called every frame
-void AFloorSwitch::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
 
+	DoorActuator->AddTarget(Door);
+	for (AActor* LinkedDoor : LinkedDoors)
+	{
+		USceneComponent* LinkedRoot = LinkedDoor ? LinkedDoor->GetRootComponent() : nullptr;
+		if (LinkedRoot)
+		{
+			// Placed meshes default to Static, which SetWorldLocation refuses to move
+			LinkedRoot->SetMobility(EComponentMobility::Movable);
+			DoorActuator->AddTarget(LinkedRoot);
+		}
+	}
+	SwitchActuator->AddTarget(FloorSwitch);
 }
 
 void AFloorSwitch::OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
 	UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult & SweepResult)
 {
 	if (!bCharacterOnSwitch)
-		bCharacterOnSwitch = true;		
+	{
+		bCharacterOnSwitch = true;
+	}
 	
-	UE_LOG(LogTemp,Warning,TEXT("Overlap Begine!!"));
-	RaiseDoor();
-	LowerFloorSwitch();
+	FIRSTPROJECT_HOT_LOG(Verbose, TEXT("Overlap Begine!!"));
+	if (DoorActuator->Curve)
+	{
+		DoorActuator->PlayForward();
+	}
+	else
+	{
+		RaiseDoor();
+	}
+
+	if (SwitchActuator->Curve)
+	{
+		SwitchActuator->PlayForward();
+	}
+	else
+	{
+		LowerFloorSwitch();
+	}
 }
 
 void AFloorSwitch::OnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
 	UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
 {
 	if (bCharacterOnSwitch)
+	{
 		bCharacterOnSwitch = false;
+	}
 	
-	UE_LOG(LogTemp,Warning,TEXT("Overlap End!!"));
+	FIRSTPROJECT_HOT_LOG(Verbose, TEXT("Overlap End!!"));
 	GetWorldTimerManager().SetTimer(SwitchHandle, this, &AFloorSwitch::CloseDoor, SwitchTime);
 }
 
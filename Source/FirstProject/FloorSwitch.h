@@ -37,6 +37,18 @@ public:
 
 	UPROPERTY(EditAnywhere, Category = "Floor Switch")
 	float SwitchTime;
+
+	/** Raises the door and any linked doors natively when it has a curve, otherwise RaiseDoor/LowerDoor run */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Floor Switch")
+	class UCurveActuatorComponent* DoorActuator;
+
+	/** Presses the switch natively when it has a curve, otherwise RaiseFloorSwitch/LowerFloorSwitch run */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Floor Switch")
+	UCurveActuatorComponent* SwitchActuator;
+
+	/** Other doors in the level opened by this switch, moved with Door */
+	UPROPERTY(EditInstanceOnly, Category = "Floor Switch")
+	TArray<AActor*> LinkedDoors;
 	
 	FTimerHandle SwitchHandle;
 
@@ -51,8 +63,6 @@ protected:
 	virtual void BeginPlay() override;
 
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
 
 	UFUNCTION()
 	void OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult & SweepResult);  
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HUDViewModel.h"
+#include "FirstProject.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("HUD View Model Notifications"), STAT_HUDViewModelNotifications, STATGROUP_FirstProject);
+
+UHUDViewModel::UHUDViewModel()
+{
+	StaminaQuantization = 0.5f;
+
+	Health = 0.f;
+	MaxHealth = 0.f;
+	Stamina = 0.f;
+	MaxStamina = 0.f;
+	Coins = 0;
+}
+
+void UHUDViewModel::SetHealth(float NewHealth, float NewMaxHealth)
+{
+	if (NewHealth != Health || NewMaxHealth != MaxHealth)
+	{
+		Health = NewHealth;
+		MaxHealth = NewMaxHealth;
+
+		INC_DWORD_STAT(STAT_HUDViewModelNotifications);
+		OnHealthChanged.Broadcast(Health, MaxHealth);
+	}
+}
+
+void UHUDViewModel::SetStamina(float NewStamina, float NewMaxStamina)
+{
+	// Always report reaching empty or full exactly so bars don't stop just short
+	const bool bAtLimit = (NewStamina <= 0.f || NewStamina >= NewMaxStamina) && NewStamina != Stamina;
+	if (bAtLimit || FMath::Abs(NewStamina - Stamina) >= StaminaQuantization || NewMaxStamina != MaxStamina)
+	{
+		Stamina = NewStamina;
+		MaxStamina = NewMaxStamina;
+
+		INC_DWORD_STAT(STAT_HUDViewModelNotifications);
+		OnStaminaChanged.Broadcast(Stamina, MaxStamina);
+	}
+}
+
+void UHUDViewModel::SetCoins(int32 NewCoins)
+{
+	if (NewCoins != Coins)
+	{
+		Coins = NewCoins;
+
+		INC_DWORD_STAT(STAT_HUDViewModelNotifications);
+		OnCoinsChanged.Broadcast(Coins);
+	}
+}
+
+void UHUDViewModel::BroadcastAll()
+{
+	OnHealthChanged.Broadcast(Health, MaxHealth);
+	OnStaminaChanged.Broadcast(Stamina, MaxStamina);
+	OnCoinsChanged.Broadcast(Coins);
+}
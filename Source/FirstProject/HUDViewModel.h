@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "HUDViewModel.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnHUDBarChanged, float, Value, float, MaxValue);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnHUDCoinsChanged, int32, Coins);
+
+/**
+ * Player stats as the HUD sees them.
+ * Widgets bind to the change events instead of polling AMain through property bindings every frame.
+ */
+UCLASS(BlueprintType)
+class FIRSTPROJECT_API UHUDViewModel : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UHUDViewModel();
+
+	UPROPERTY(BlueprintAssignable, Category = "HUD")
+	FOnHUDBarChanged OnHealthChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "HUD")
+	FOnHUDBarChanged OnStaminaChanged;
+
+	UPROPERTY(BlueprintAssignable, Category = "HUD")
+	FOnHUDCoinsChanged OnCoinsChanged;
+
+	/** Stamina changes smaller than this are not broadcast, it drains and refills every frame */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "HUD")
+	float StaminaQuantization;
+
+	void SetHealth(float NewHealth, float NewMaxHealth);
+
+	void SetStamina(float NewStamina, float NewMaxStamina);
+
+	void SetCoins(int32 NewCoins);
+
+	/** Fire every event with the current values, for widgets that bind after construction */
+	UFUNCTION(BlueprintCallable, Category = "HUD")
+	void BroadcastAll();
+
+	UFUNCTION(BlueprintPure, Category = "HUD")
+	FORCEINLINE float GetHealthPercent() const { return MaxHealth > 0.f ? Health / MaxHealth : 0.f; }
+
+	UFUNCTION(BlueprintPure, Category = "HUD")
+	FORCEINLINE float GetStaminaPercent() const { return MaxStamina > 0.f ? Stamina / MaxStamina : 0.f; }
+
+	UFUNCTION(BlueprintPure, Category = "HUD")
+	FORCEINLINE int32 GetCoins() const { return Coins; }
+
+private:
+
+	float Health;
+	float MaxHealth;
+	float Stamina;
+	float MaxStamina;
+	int32 Coins;
+};
@@ -2,16 +2,25 @@
 
 
 #include "Item.h"
+#include "FirstProject.h"
 #include "Components/SphereComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "Particles/ParticleSystemComponent.h"
+#include "PickupSubsystem.h"
+#include "PickupManager.h"
+#include "Engine/World.h"
+#include "TestWorld.h"
+#include "Misc/AutomationTest.h"
 
+DECLARE_CYCLE_STAT(TEXT("Item Tick"), STAT_ItemTick, STATGROUP_FirstProject);
 
 // Sets default values
 AItem::AItem()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
+	// Enabled in BeginPlay only for items that rotate themselves
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	CollisionVolume = CreateDefaultSubobject<USphereComponent>(TEXT("CollisionVolume"));
 	RootComponent = CollisionVolume;
@@ -24,6 +33,12 @@ AItem::AItem()
 
 	bRotate = false;
 	RotationRate = 45.f;
+
+	bInstancedMesh = false;
+	PickupBatchIndex = INDEX_NONE;
+	PickupInstanceIndex = INDEX_NONE;
+
+	WorldStateId = INDEX_NONE;
 }
 
 // Called when the game starts or when spawned
@@ -33,12 +48,75 @@ void AItem::BeginPlay()
 
 	CollisionVolume->OnComponentBeginOverlap.AddDynamic(this, &AItem::OnOverlapBegin);
 	CollisionVolume->OnComponentEndOverlap.AddDynamic(this, &AItem::OnOverlapEnd);
-	
+
+	if (bInstancedMesh && Mesh->GetStaticMesh())
+	{
+		UPickupSubsystem* Pickups = GetWorld()->GetSubsystem<UPickupSubsystem>();
+		if (Pickups)
+		{
+			Pickups->GetPickupManager()->RegisterItem(this);
+		}
+	}
+
+	// Instanced items are spun by the pickup manager
+	SetActorTickEnabled(bRotate && PickupInstanceIndex == INDEX_NONE);
+
+	ReleaseUnusedComponents();
+}
+
+void AItem::SetRotation(bool bInRotate, float InRotationRate)
+{
+	bRotate = bInRotate;
+	RotationRate = InRotationRate;
+
+	if (PickupInstanceIndex != INDEX_NONE)
+	{
+		UPickupSubsystem* Pickups = GetWorld()->GetSubsystem<UPickupSubsystem>();
+		APickupManager* Manager = Pickups ? Pickups->FindPickupManager() : nullptr;
+		if (Manager)
+		{
+			Manager->UpdateItemRotation(this);
+		}
+	}
+	SetActorTickEnabled(bRotate && PickupInstanceIndex == INDEX_NONE);
+}
+
+void AItem::ReleaseUnusedComponents()
+{
+	if (IdleParticlesComponent && !IdleParticlesComponent->Template)
+	{
+		IdleParticlesComponent->DestroyComponent();
+		IdleParticlesComponent = nullptr;
+	}
+
+	// Mesh is drawn by the pickup manager or has nothing to draw, unless something hangs off it
+	if (Mesh && (PickupInstanceIndex != INDEX_NONE || !Mesh->GetStaticMesh()) && Mesh->GetNumChildrenComponents() == 0)
+	{
+		Mesh->DestroyComponent();
+		Mesh = nullptr;
+	}
+}
+
+void AItem::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (PickupInstanceIndex != INDEX_NONE)
+	{
+		UPickupSubsystem* Pickups = GetWorld()->GetSubsystem<UPickupSubsystem>();
+		APickupManager* Manager = Pickups ? Pickups->FindPickupManager() : nullptr;
+		if (Manager && !Manager->IsPendingKill())
+		{
+			Manager->UnregisterItem(this);
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
 void AItem::Tick(float DeltaTime)
 {
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_ItemTick);
+
 	Super::Tick(DeltaTime);
 
 	if(bRotate)
@@ -65,3 +143,43 @@ void AItem::OnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* Other
 	
 }
 
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** Rough item memory: object sizes plus resources of the actor and its components */
+static SIZE_T GetItemFootprint(const AItem* Item)
+{
+	SIZE_T Bytes = Item->GetClass()->GetStructureSize() + Item->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	for (UActorComponent* Component : Item->GetComponents())
+	{
+		Bytes += Component->GetClass()->GetStructureSize() + Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	}
+	return Bytes;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FItemFootprintTest, "FirstProject.Item.ReleaseUnusedComponents",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FItemFootprintTest::RunTest(const FString& Parameters)
+{
+	FFirstProjectTestWorld TestWorld(TEXT("ItemFootprintTest"));
+
+	// A bare item has no mesh and no idle particle template, so both components are unused
+	AItem* Item = TestWorld.Spawn<AItem>();
+	const int32 ComponentsBefore = Item->GetComponents().Num();
+	const SIZE_T BytesBefore = GetItemFootprint(Item);
+
+	// BeginPlay ends with ReleaseUnusedComponents
+	Item->DispatchBeginPlay();
+	const int32 ComponentsAfter = Item->GetComponents().Num();
+	const SIZE_T BytesAfter = GetItemFootprint(Item);
+
+	AddInfo(FString::Printf(TEXT("%d components, %llu bytes before release; %d components, %llu bytes after"),
+		ComponentsBefore, static_cast<uint64>(BytesBefore), ComponentsAfter, static_cast<uint64>(BytesAfter)));
+	TestTrue(TEXT("Unused components are destroyed"), ComponentsAfter < ComponentsBefore);
+	TestTrue(TEXT("Item footprint drops"), BytesAfter < BytesBefore);
+	TestNull(TEXT("Mesh without a static mesh is released"), Item->Mesh);
+	TestNull(TEXT("Idle particles without a template are released"), Item->IdleParticlesComponent);
+	return true;
+}
+
+#endif
@@ -23,7 +23,7 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Item | Mesh")
 	class UStaticMeshComponent* Mesh;
 
-	/**Particle System Component */
+	/**Particle System Component, released in BeginPlay when it has no template */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item | part")
 	class UParticleSystemComponent* IdleParticlesComponent;
 
@@ -33,16 +33,37 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item | Sounds")
 	class USoundCue* OverlapSound;
 
+	/** Change at runtime through SetRotation, so instanced items follow */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item | ItemProperties")
 	bool bRotate;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item | ItemProperties")
 	float RotationRate;
+
+	UFUNCTION(BlueprintCallable, Category = "Item | ItemProperties")
+	void SetRotation(bool bInRotate, float InRotationRate);
+
+	/** Draw the mesh through the shared pickup manager instead of this actor's own component */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Item | Mesh")
+	bool bInstancedMesh;
+
+	/** Slot in the pickup manager, INDEX_NONE when the item draws its own mesh */
+	int32 PickupBatchIndex;
+	int32 PickupInstanceIndex;
+
+	/** Stable id within the level for pickups and explosives, assigned when the level is saved in the editor */
+	UPROPERTY(VisibleAnywhere, Category = "Item | Save", NonPIEDuplicateTransient)
+	int32 WorldStateId;
 	
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Destroy optional components this item's setup leaves unused */
+	void ReleaseUnusedComponents();
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
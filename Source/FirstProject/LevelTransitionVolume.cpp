@@ -4,6 +4,7 @@
 #include "LevelTransitionVolume.h"
 
 #include "Main.h"
+#include "AutosaveSubsystem.h"
 #include "Components/BoxComponent.h"
 #include "Components/BillboardComponent.h"
 
@@ -47,6 +48,11 @@ void ALevelTransitionVolume::OnOverlapBegin(UPrimitiveComponent* OverlappedCompo
 		AMain* Main = Cast<AMain>(OtherActor);
 		if (Main)
 		{
+			// The snapshot carries the player's stats into NextLevel, the write carries on in the background through the level load
+			if (Main->MovementStatus != EMovementStatus::EMS_Dead)
+			{
+				UAutosaveSubsystem::SaveMain(Main, EAutosaveReason::LevelTransition, NextLevel);
+			}
 			Main->SwitchLevel(NextLevel);
 		}
 	}
@@ -2,6 +2,7 @@
 
 
 #include "Main.h"
+#include "FirstProject.h"
 
 #include "GameFramework/Actor.h"
 
@@ -19,8 +20,17 @@
 #include "Kismet/KismetMathLibrary.h"
 #include "MainPlayerController.h"
 #include "FirstSaveGame.h"
+#include "AutosaveSubsystem.h"
+#include "WorldStateSubsystem.h"
 #include "ItemStorage.h"
 #include "Blueprint/UserWidget.h"
+#include "HUDViewModel.h"
+#include "ReplaySubsystem.h"
+#include "Components/LineBatchComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Main Tick"), STAT_MainTick, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Update Combat Target"), STAT_UpdateCombatTarget, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Load Game"), STAT_LoadGame, STATGROUP_FirstProject);
 
 // Sets default values
 AMain::AMain()
@@ -68,6 +78,8 @@ AMain::AMain()
 	Stamina = 120.f;
 	Coins = 0;
 
+	HUDViewModel = CreateDefaultSubobject<UHUDViewModel>(TEXT("HUDViewModel"));
+
 	RunningSpeed = 650.f;
 	SprintingSpeed = 950.f;
 	bShiftKeyDown = false;
@@ -88,15 +100,52 @@ AMain::AMain()
 
 	bMovingForward = false;
 	bMovingRight = false;
+
+	PickupHistoryCapacity = 256;
+
+	HUDResyncInterval = 0.25f;
+	SecondsUntilHUDResync = 0.f;
 }
 
 void AMain::ShowPickUpLocations()
 {
-	for(FVector Location : PickUpLocations)
+#if FIRSTPROJECT_DEBUG_TOOLS
+	ULineBatchComponent* LineBatcher = GetWorld()->PersistentLineBatcher;
+	if (!LineBatcher || PickupHistory.Num() == 0)
+	{
+		return;
+	}
+
+	const int32 Segments = 8;
+	const float Radius = 25.f;
+	const float LifeTime = 10.f;
+	const float Thickness = .5f;
+
+	FVector Ring[Segments + 1];
+	for (int32 Segment = 0; Segment <= Segments; ++Segment)
 	{
-		UKismetSystemLibrary::DrawDebugSphere(this, Location, 25.f, 8, FLinearColor::Green,
-			10.f, .5f);
+		float Sin, Cos;
+		FMath::SinCos(&Sin, &Cos, 2.f * PI * Segment / Segments);
+		Ring[Segment] = FVector(Cos, Sin, 0.f) * Radius;
 	}
+
+	// Three rings per pickup, all handed to the line batcher at once instead of a debug sphere each
+	TArray<FBatchedLine> Lines;
+	Lines.Reserve(PickupHistory.Num() * Segments * 3);
+	for (int32 Index = 0; Index < PickupHistory.Num(); ++Index)
+	{
+		const FVector& Center = PickupHistory[Index].Location;
+		for (int32 Segment = 0; Segment < Segments; ++Segment)
+		{
+			const FVector& Start = Ring[Segment];
+			const FVector& End = Ring[Segment + 1];
+			Lines.Emplace(Center + Start, Center + End, FLinearColor::Green, LifeTime, Thickness, SDPG_World);
+			Lines.Emplace(Center + FVector(Start.X, 0.f, Start.Y), Center + FVector(End.X, 0.f, End.Y), FLinearColor::Green, LifeTime, Thickness, SDPG_World);
+			Lines.Emplace(Center + FVector(0.f, Start.X, Start.Y), Center + FVector(0.f, End.X, End.Y), FLinearColor::Green, LifeTime, Thickness, SDPG_World);
+		}
+	}
+	LineBatcher->DrawLines(Lines);
+#endif
 }
 
 void AMain::SetInterToEnemy(bool Interp)
@@ -134,6 +183,7 @@ void AMain::DecrementHealth(float Amount)
 	{
 		Health -= Amount;
 	}
+	SyncHUDViewModel();
 }
 
 float AMain::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator,
@@ -157,6 +207,7 @@ float AMain::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, ACo
 	{
 		Health -= DamageAmount;		
 	}	
+	SyncHUDViewModel();
 
 	return DamageAmount;
 }
@@ -164,6 +215,7 @@ float AMain::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, ACo
 void AMain::IncrementCoin(const int32 Amount)
 {
 	Coins += Amount;
+	SyncHUDViewModel();
 }
 
 void AMain::IncrementHealth(const float Amount)
@@ -176,6 +228,17 @@ void AMain::IncrementHealth(const float Amount)
 	{
 		Health += Amount;		
 	}
+	SyncHUDViewModel();
+}
+
+void AMain::SyncHUDViewModel()
+{
+	if (HUDViewModel)
+	{
+		HUDViewModel->SetHealth(Health, MaxHealth);
+		HUDViewModel->SetStamina(Stamina, MaxStamina);
+		HUDViewModel->SetCoins(Coins);
+	}
 }
 
 void AMain::Die()
@@ -196,7 +259,10 @@ void AMain::BeginPlay()
 {
 	Super::BeginPlay();
 	SetMovementStatus(EMovementStatus::EMS_Normal);
+	Replay = GetWorld()->GetSubsystem<UReplaySubsystem>();
+	PickupHistory.SetCapacity(PickupHistoryCapacity);
 	SetStaminaStatus(EStaminaStatus::ESS_Normal);
+	SyncHUDViewModel();
 
 	MainPlayerController = Cast<AMainPlayerController>(GetController());
 	FString Map = GetWorld()->GetMapName();;
@@ -216,19 +282,55 @@ void AMain::BeginPlay()
 			MainPlayerController->GameModeOnly();
 		}
 	}
-	
+
+	UAutosaveSubsystem::NotifyPlayerStarted(this);
 }
 
 // Called every frame
 void AMain::Tick(float DeltaTime)
 {
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_MainTick);
+
 	Super::Tick(DeltaTime);
 
+	if (Replay && (Replay->IsRecording() || Replay->IsReplaying()))
+	{
+		Replay->ProcessPlayerInput(this);
+	}
+
 	if (MovementStatus == EMovementStatus::EMS_Dead)
 	{
 		return;
 	}
 
+	UpdateStamina(DeltaTime);
+
+	// Stat changes in C++ push to the view model, this only catches stats Blueprints wrote directly
+	SecondsUntilHUDResync -= DeltaTime;
+	if (SecondsUntilHUDResync <= 0.f)
+	{
+		SecondsUntilHUDResync = HUDResyncInterval;
+		SyncHUDViewModel();
+	}
+
+	if (bInterpToEnemy && CombatTarget)
+	{
+		FRotator LookAtYaw = GetLockAtRotationYaw(CombatTarget->GetActorLocation());
+		FRotator InterpRotation = FMath::RInterpTo(GetActorRotation(), LookAtYaw, DeltaTime, InterpSpeed);
+
+		SetActorRotation(InterpRotation);
+	}
+
+	// The controller reads the target itself while the enemy health bar is showing
+	if (CombatTarget)
+	{
+		CombatTargetLocation = CombatTarget->GetActorLocation();
+	}
+}
+
+void AMain::UpdateStamina(float DeltaTime)
+{
+	const float PreviousStamina = Stamina;
 	float DeltaStamina = StaminaDrainRate * DeltaTime;
 	switch (StaminaStatus)
 	{
@@ -332,21 +434,9 @@ void AMain::Tick(float DeltaTime)
 			break;		
 	}
 
-	if (bInterpToEnemy && CombatTarget)
-	{
-		FRotator LookAtYaw = GetLockAtRotationYaw(CombatTarget->GetActorLocation());
-		FRotator InterpRotation = FMath::RInterpTo(GetActorRotation(), LookAtYaw, DeltaTime, InterpSpeed);
-
-		SetActorRotation(InterpRotation);
-	}
-
-	if (CombatTarget)
+	if (Stamina != PreviousStamina && HUDViewModel)
 	{
-		CombatTargetLocation = CombatTarget->GetActorLocation();
-		if (MainPlayerController)
-		{
-			MainPlayerController->EnemyLocation = CombatTargetLocation;
-		}
+		HUDViewModel->SetStamina(Stamina, MaxStamina);
 	}
 }
 
@@ -372,8 +462,9 @@ void AMain::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 	PlayerInputComponent->BindAction("LMB", IE_Pressed, this, &AMain::LMBDown);
 	PlayerInputComponent->BindAction("LMB", IE_Released, this, &AMain::LMBUp);
 
-	PlayerInputComponent->BindAction("ESC", IE_Pressed, this, &AMain::ESCDown);
-	PlayerInputComponent->BindAction("ESC", IE_Released, this, &AMain::ESCUp);
+	// The pause menu pauses the world, ESC has to close it again
+	PlayerInputComponent->BindAction("ESC", IE_Pressed, this, &AMain::ESCDown).bExecuteWhenPaused = true;
+	PlayerInputComponent->BindAction("ESC", IE_Released, this, &AMain::ESCUp).bExecuteWhenPaused = true;
 
 	PlayerInputComponent->BindAxis("MoveForward", this, &AMain::MoveForwrd);
 	PlayerInputComponent->BindAxis("MoveRight", this, &AMain::MoveRight);
@@ -529,7 +620,7 @@ void AMain::Attack()
 		UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
 		if(AnimInstance && CombatMontage)
 		{
-			int32 Section = FMath::RandRange(0,1);
+			int32 Section = UReplaySubsystem::GetWorldRandom(this, EGameplayRandom::Combat).RandRange(0,1);
 			switch (Section)
 			{
 				case 0 :
@@ -586,6 +677,9 @@ void AMain::Jump()
 
 void AMain::UpdateCombatTarget()
 {
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_UpdateCombatTarget);
+	CSV_CUSTOM_STAT(FirstProject, CombatTargetUpdates, 1, ECsvCustomStatOp::Accumulate);
+
 	TArray<AActor*> OverlappingActors;
 	GetOverlappingActors(OverlappingActors, EnemyFilter);
 
@@ -644,54 +738,66 @@ void AMain::SwitchLevel(FName LevelName)
 
 void AMain::SaveGame()
 {
-	
-	UFirstSaveGame* GameSaveInstance = Cast<UFirstSaveGame>(
-		UGameplayStatics::CreateSaveGameObject(UFirstSaveGame::StaticClass())); 
-
-	GameSaveInstance->CharacterStats.Health = Health;
-	GameSaveInstance->CharacterStats.MaxHealth = MaxHealth;
-	GameSaveInstance->CharacterStats.Stamina = Stamina;
-	GameSaveInstance->CharacterStats.MaxHealth = MaxStamina;
-	GameSaveInstance->CharacterStats.Coins = Coins;
-	GameSaveInstance->CharacterStats.Location = GetActorLocation();
-	GameSaveInstance->CharacterStats.Rotation = GetActorRotation();
+	FIRSTPROJECT_LLM_SCOPE(EFirstProjectLLMTag::SaveData);
+
+	UAutosaveSubsystem::SaveMain(this, EAutosaveReason::Manual);
+}
+
+void AMain::CaptureSaveData(FSaveGameData& Data) const
+{
+	Data.CharacterStats.Health = Health;
+	Data.CharacterStats.MaxHealth = MaxHealth;
+	Data.CharacterStats.Stamina = Stamina;
+	Data.CharacterStats.MaxHealth = MaxStamina;
+	Data.CharacterStats.Coins = Coins;
+	Data.CharacterStats.Location = GetActorLocation();
+	Data.CharacterStats.Rotation = GetActorRotation();
 	
 	FString MapName = GetWorld()->GetMapName();
 	MapName.RemoveFromStart(GetWorld()->StreamingLevelsPrefix);
-	GameSaveInstance->CharacterStats.LevelName = MapName;
+	Data.CharacterStats.LevelName = MapName;
 	
 	
 	if (EquippedWeapon)
 	{
-		GameSaveInstance->CharacterStats.WeaponName = EquippedWeapon->Name;		
+		Data.CharacterStats.WeaponName = EquippedWeapon->Name;		
 	}
 
-	UGameplayStatics::SaveGameToSlot(GameSaveInstance, GameSaveInstance->PlayerName, GameSaveInstance->UserIndex) ;
+	UWorldStateSubsystem::CaptureState(this, Data);
 }
 
 void AMain::LoadGame(bool SetPotion)
 {
-	
-	UFirstSaveGame* GameLoadInstance = Cast<UFirstSaveGame>(
-		UGameplayStatics::CreateSaveGameObject(UFirstSaveGame::StaticClass()));
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_LoadGame);
+	CSV_SCOPED_TIMING_STAT(FirstProject, LoadGame);
 
-	GameLoadInstance = Cast<UFirstSaveGame>(
-		UGameplayStatics::LoadGameFromSlot(GameLoadInstance->PlayerName, GameLoadInstance->UserIndex));
+	
+	FSaveGameData SaveData;
+	{
+		FIRSTPROJECT_LLM_SCOPE(EFirstProjectLLMTag::SaveData);
+		if (!UAutosaveSubsystem::LoadMain(this, SaveData))
+		{
+			return;
+		}
+	}
 
-	Health = GameLoadInstance->CharacterStats.Health;
-	MaxHealth = GameLoadInstance->CharacterStats.MaxHealth;
-	Stamina = GameLoadInstance->CharacterStats.Stamina;
-	MaxStamina = GameLoadInstance->CharacterStats.MaxHealth;
-	Coins = GameLoadInstance->CharacterStats.Coins;
+	Health = SaveData.CharacterStats.Health;
+	MaxHealth = SaveData.CharacterStats.MaxHealth;
+	Stamina = SaveData.CharacterStats.Stamina;
+	MaxStamina = SaveData.CharacterStats.MaxHealth;
+	Coins = SaveData.CharacterStats.Coins;
+	SyncHUDViewModel();
+	UWorldStateSubsystem::RestoreState(this, SaveData);
 
 	if (WeaponStorage)
     	{
     		AItemStorage* Weapons = GetWorld()->SpawnActor<AItemStorage>(WeaponStorage);
     		if (Weapons)
     		{
-    			FString WeaponeName = GameLoadInstance->CharacterStats.WeaponName;
+    			FString WeaponeName = SaveData.CharacterStats.WeaponName;
     			if (WeaponeName != TEXT(""))
     			{
+    				FIRSTPROJECT_LLM_SCOPE(EFirstProjectLLMTag::Weapons);
     				AWeapon* WeaponToEquip = GetWorld()->SpawnActor<AWeapon>(Weapons->WeaponMap[WeaponeName]);
     				WeaponToEquip->Equip(this);
     			}	
@@ -700,17 +806,17 @@ void AMain::LoadGame(bool SetPotion)
 
 	if (SetPotion)
 	{
-		SetActorLocation(GameLoadInstance->CharacterStats.Location);
-		SetActorRotation(GameLoadInstance->CharacterStats.Rotation);
+		SetActorLocation(SaveData.CharacterStats.Location);
+		SetActorRotation(SaveData.CharacterStats.Rotation);
 	}
 
 	SetMovementStatus(EMovementStatus::EMS_Normal);
 	GetMesh()->bPauseAnims = false;
 	GetMesh()->bNoSkeletonUpdate = false;
 
-	if (GameLoadInstance->CharacterStats.LevelName != TEXT(""))
+	if (SaveData.CharacterStats.LevelName != TEXT(""))
 	{
-		FName LevelName(*GameLoadInstance->CharacterStats.LevelName);
+		FName LevelName(*SaveData.CharacterStats.LevelName);
 		SwitchLevel(LevelName);
 	}
 	
@@ -718,26 +824,35 @@ void AMain::LoadGame(bool SetPotion)
 
 void AMain::LoadGameNoSwitch()
 {
-	UFirstSaveGame* GameLoadInstance = Cast<UFirstSaveGame>(
-	UGameplayStatics::CreateSaveGameObject(UFirstSaveGame::StaticClass()));
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_LoadGame);
+	CSV_SCOPED_TIMING_STAT(FirstProject, LoadGame);
 
-	GameLoadInstance = Cast<UFirstSaveGame>(
-		UGameplayStatics::LoadGameFromSlot(GameLoadInstance->PlayerName, GameLoadInstance->UserIndex));
+	FSaveGameData SaveData;
+	{
+		FIRSTPROJECT_LLM_SCOPE(EFirstProjectLLMTag::SaveData);
+		if (!UAutosaveSubsystem::LoadMain(this, SaveData))
+		{
+			return;
+		}
+	}
 
-	Health = GameLoadInstance->CharacterStats.Health;
-	MaxHealth = GameLoadInstance->CharacterStats.MaxHealth;
-	Stamina = GameLoadInstance->CharacterStats.Stamina;
-	MaxStamina = GameLoadInstance->CharacterStats.MaxHealth;
-	Coins = GameLoadInstance->CharacterStats.Coins;
+	Health = SaveData.CharacterStats.Health;
+	MaxHealth = SaveData.CharacterStats.MaxHealth;
+	Stamina = SaveData.CharacterStats.Stamina;
+	MaxStamina = SaveData.CharacterStats.MaxHealth;
+	Coins = SaveData.CharacterStats.Coins;
+	SyncHUDViewModel();
+	UWorldStateSubsystem::RestoreState(this, SaveData);
 
 	if (WeaponStorage)
 	{
 		AItemStorage* Weapons = GetWorld()->SpawnActor<AItemStorage>(WeaponStorage);
 		if (Weapons)
 		{
-			FString WeaponeName = GameLoadInstance->CharacterStats.WeaponName;
+			FString WeaponeName = SaveData.CharacterStats.WeaponName;
 			if (WeaponeName != TEXT(""))
 			{
+				FIRSTPROJECT_LLM_SCOPE(EFirstProjectLLMTag::Weapons);
 				AWeapon* WeaponToEquip = GetWorld()->SpawnActor<AWeapon>(Weapons->WeaponMap[WeaponeName]);
 				WeaponToEquip->Equip(this);
 			}	
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "PickupHistory.h"
 #include "Main.generated.h"
 
 UENUM(BlueprintType)
@@ -47,8 +48,14 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Combat")
 	FVector CombatTargetLocation;
 
-	TArray<FVector> PickUpLocations;
+	/** Recent pickups for ShowPickUpLocations and FirstProject.ExportPickupHistory */
+	FPickupHistory PickupHistory;
+
+	/** Pickups kept in the history, the oldest are dropped beyond this */
+	UPROPERTY(EditDefaultsOnly, Category = "Debug", meta = (ClampMin = "1"))
+	int32 PickupHistoryCapacity;
 	
+	/** Draw a marker at every pickup in the history for ten seconds */
 	UFUNCTION(BlueprintCallable)
 	void ShowPickUpLocations();
 
@@ -66,6 +73,9 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
 	float MinSprintStamina;
 	
+	/** Advance the sprint stamina state machine by one frame */
+	void UpdateStamina(float DeltaTime);
+
 	float InterpSpeed;
 	bool bInterpToEnemy;
 	void SetInterToEnemy(bool Interp);
@@ -139,6 +149,19 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Player Stats")
 	int32 Coins;
+
+	/** Change notifications for the HUD, fired only when a stat actually changes */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Player Stats")
+	class UHUDViewModel* HUDViewModel;
+
+	/** Seconds between checks for stats Blueprints set directly, the C++ setters push their changes right away */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Player Stats")
+	float HUDResyncInterval;
+
+	float SecondsUntilHUDResync;
+
+	/** Push the current stats to the HUD view model */
+	void SyncHUDViewModel();
 	
 	void DecrementHealth(float Amount);
 
@@ -250,12 +273,22 @@ public:
 
 	void SwitchLevel(FName LevelName);
 
+	/** Save in the background, see UAutosaveSubsystem */
 	UFUNCTION(BlueprintCallable)
 	void SaveGame();
 
+	/** Copy everything a save slot holds */
+	void CaptureSaveData(struct FSaveGameData& Data) const;
+
 	UFUNCTION(BlueprintCallable)
 	void LoadGame(bool SetPotion);
 
 	void LoadGameNoSwitch();
 
+private:
+
+	/** Records or plays back input while an input capture is running */
+	UPROPERTY(Transient)
+	class UReplaySubsystem* Replay;
+
 };
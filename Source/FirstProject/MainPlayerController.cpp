@@ -3,28 +3,67 @@
 
 #include "MainPlayerController.h"
 #include "Blueprint/UserWidget.h"
+#include "FirstProject.h"
+#include "Main.h"
+#include "Enemy.h"
+#include "EnemyHealthBarWidget.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "SceneView.h"
+#include "WidgetCacheSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Blueprint/WidgetTree.h"
+#include "Components/InvalidationBox.h"
+
+DECLARE_CYCLE_STAT(TEXT("Controller HUD Tick"), STAT_ControllerHUDTick, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Enemy Health Bar Update"), STAT_EnemyHealthBarUpdate, STATGROUP_FirstProject);
+
+AMainPlayerController::AMainPlayerController()
+{
+	bEnemyHealthBarVisible = false;
+	bPauseMenuVisible = false;
+
+	HealthBarMoveThreshold = 1.f;
+	bCacheHUDLayout = false;
+
+	MaxEnemyHealthBars = 6;
+	EnemyHealthBarCullDistance = 3000.f;
+
+	bPrewarmWidgets = false;
+
+	PausedMaxFPS = 30.f;
+	UnpausedMaxFPS = 0.f;
+	bFrameRateCapped = false;
+}
 
 void AMainPlayerController::DisplayEnemyHealthBar()
 {
-	if (EnemyHealthBar)
-	{
-		bEnemyHealthBarVisible = true;
-		EnemyHealthBar->SetVisibility(ESlateVisibility::Visible);
-	}
+	// The combat target keeps its bar even when the pool is full
+	bEnemyHealthBarVisible = true;
 }
 
 void AMainPlayerController::RemoveEnemyHealthBar()
 {
-	if (EnemyHealthBar)
+	bEnemyHealthBarVisible = false;
+}
+
+void AMainPlayerController::AddEngagedEnemy(AEnemy* Enemy)
+{
+	if (Enemy)
 	{
-		bEnemyHealthBarVisible = false;
-		EnemyHealthBar->SetVisibility(ESlateVisibility::Hidden);
+		EngagedEnemies.AddUnique(Enemy);
 	}
 }
 
+void AMainPlayerController::RemoveEngagedEnemy(AEnemy* Enemy)
+{
+	EngagedEnemies.RemoveSingleSwap(Enemy, false);
+}
+
 void AMainPlayerController::DisplayPauseMenu_Implementation()
 {
-	if (PauseMenu)
+	if (GetPauseMenu())
 	{
 		bPauseMenuVisible = true;
 		PauseMenu->SetVisibility(ESlateVisibility::Visible);
@@ -33,6 +72,10 @@ void AMainPlayerController::DisplayPauseMenu_Implementation()
 		
 		SetInputMode(InputModeGameAndUI);
 		bShowMouseCursor = true;
+
+		// Stops actor, component and timer ticks, AI and physics. Only the UI and this controller keep running
+		SetPause(true);
+		SetPausedFrameRateCap(IsPaused());
 	}
 	
 }
@@ -46,7 +89,9 @@ void AMainPlayerController::RemovePauseMenu_Implementation()
 		bShowMouseCursor = false;
 		
 		bPauseMenuVisible = false;
-		
+
+		SetPause(false);
+		SetPausedFrameRateCap(false);
 	}
 }
 
@@ -62,6 +107,26 @@ void AMainPlayerController::TogglePauseMenu()
 	}
 }
 
+void AMainPlayerController::SetPausedFrameRateCap(bool bPaused)
+{
+	if (!GEngine)
+	{
+		return;
+	}
+
+	if (bPaused && !bFrameRateCapped && PausedMaxFPS > 0.f)
+	{
+		UnpausedMaxFPS = GEngine->GetMaxFPS();
+		GEngine->SetMaxFPS(PausedMaxFPS);
+		bFrameRateCapped = true;
+	}
+	else if (!bPaused && bFrameRateCapped)
+	{
+		GEngine->SetMaxFPS(UnpausedMaxFPS);
+		bFrameRateCapped = false;
+	}
+}
+
 void AMainPlayerController::GameModeOnly()
 {
 	FInputModeGameOnly InputModeGameOnly;
@@ -69,56 +134,305 @@ void AMainPlayerController::GameModeOnly()
 	SetInputMode(InputModeGameOnly);
 }
 
+void AMainPlayerController::PrewarmWidgets()
+{
+	GetPauseMenu();
+
+	while (EnemyHealthBarPool.Num() < GetEnemyHealthBarLimit())
+	{
+		UUserWidget* Widget = CreateEnemyHealthBar();
+		if (!Widget)
+		{
+			break;
+		}
+		Widget->SetVisibility(ESlateVisibility::Collapsed);
+		FreeEnemyHealthBars.Add(Widget);
+	}
+}
+
+UUserWidget* AMainPlayerController::GetCachedWidget(TSubclassOf<UUserWidget> WidgetClass)
+{
+	FIRSTPROJECT_LLM_SCOPE(EFirstProjectLLMTag::HUDWidgets);
+
+	UGameInstance* GameInstance = GetGameInstance();
+	UWidgetCacheSubsystem* WidgetCache = GameInstance ? GameInstance->GetSubsystem<UWidgetCacheSubsystem>() : nullptr;
+	if (WidgetCache)
+	{
+		return WidgetCache->GetWidget(WidgetClass, this);
+	}
+	return WidgetClass ? CreateWidget<UUserWidget>(this, WidgetClass) : nullptr;
+}
+
+UUserWidget* AMainPlayerController::GetPauseMenu()
+{
+	if (!PauseMenu && WPauseMenu)
+	{
+		PauseMenu = GetCachedWidget(WPauseMenu);
+	}
+
+	if (PauseMenu && !PauseMenu->IsInViewport())
+	{
+		// Above the HUD and the health bars, which may be added after it
+		PauseMenu->AddToViewport(10);
+		PauseMenu->SetVisibility(ESlateVisibility::Hidden);
+	}
+	return PauseMenu;
+}
+
 void AMainPlayerController::BeginPlay()
 {
 	Super::BeginPlay();
 
 	if(HUDOverlayAsset)
 	{
-		HUDOverlay = CreateWidget<UUserWidget>(this, HUDOverlayAsset);
+		HUDOverlay = GetCachedWidget(HUDOverlayAsset);
 	}
-	
-	HUDOverlay->AddToViewport();
-	HUDOverlay->SetVisibility(ESlateVisibility::Visible);
 
-	if(WEnemyHealthBar)
+	if (HUDOverlay)
 	{
-		EnemyHealthBar = CreateWidget<UUserWidget>(this, WEnemyHealthBar);
-		if (EnemyHealthBar)
+		FIRSTPROJECT_LLM_SCOPE(EFirstProjectLLMTag::HUDWidgets);
+		UWidget* Root = HUDOverlay->WidgetTree ? HUDOverlay->WidgetTree->RootWidget : nullptr;
+		// The tree can only change before its Slate widgets are built, the cached overlay keeps its box across levels
+		if (bCacheHUDLayout && Root && !Root->IsA<UInvalidationBox>() && !HUDOverlay->GetCachedWidget().IsValid())
 		{
-			EnemyHealthBar->AddToViewport();
-			EnemyHealthBar->SetVisibility(ESlateVisibility::Hidden);
+			// Cached until one of its widgets invalidates, instead of laid out and painted every frame
+			UInvalidationBox* InvalidationBox = HUDOverlay->WidgetTree->ConstructWidget<UInvalidationBox>(UInvalidationBox::StaticClass());
+			InvalidationBox->AddChild(Root);
+			HUDOverlay->WidgetTree->RootWidget = InvalidationBox;
 		}
+		if (!HUDOverlay->IsInViewport())
+		{
+			HUDOverlay->AddToViewport();
+		}
+		HUDOverlay->SetVisibility(ESlateVisibility::Visible);
+	}
 
-		const FVector2D Alignment(0.f); 
-		EnemyHealthBar->SetAlignmentInViewport(Alignment);
+	if (ShowsCombatTargetOnly() && MaxEnemyHealthBars > 1)
+	{
+		UE_LOG(LogFirstProject, Warning, TEXT("%s is not a UEnemyHealthBarWidget, showing a single enemy health bar instead of %d. Reparent it to pool more"),
+			*WEnemyHealthBar->GetName(), MaxEnemyHealthBars);
 	}
 
-	if(WPauseMenu)
+	if (bPrewarmWidgets)
 	{
-		PauseMenu = CreateWidget<UUserWidget>(this, WPauseMenu);
-		if (PauseMenu)
-		{
-			PauseMenu->AddToViewport();
-			PauseMenu->SetVisibility(ESlateVisibility::Hidden);
-		}
-	}	
+		PrewarmWidgets();
+	}
+}
+
+void AMainPlayerController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	SetPausedFrameRateCap(false);
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AMainPlayerController::Tick(float DeltaSeconds)
 {
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_ControllerHUDTick);
+
 	Super::Tick(DeltaSeconds);
 
-	if (EnemyHealthBar)
+	// Controllers tick while paused, but nothing the bars follow can move
+	if (!IsPaused())
+	{
+		UpdateEnemyHealthBars();
+	}
+}
+
+void AMainPlayerController::UpdateEnemyHealthBars()
+{
+	EngagedEnemies.RemoveAllSwap([](const TWeakObjectPtr<AEnemy>& Enemy)
 	{
-		FVector2D PositionInViewport;
-		ProjectWorldLocationToScreen(EnemyLocation, PositionInViewport);
-		PositionInViewport.Y -= 100.0f;
-		const FVector2D SizeInViewport(250.0f, 25.0f);
+		return !Enemy.IsValid() || !Enemy->Alive();
+	}, false);
 
-		EnemyHealthBar->SetPositionInViewport(PositionInViewport);
-		EnemyHealthBar->SetDesiredSizeInViewport(SizeInViewport);
-				
+	if (EngagedEnemies.Num() == 0 && ActiveHealthBars.Num() == 0)
+	{
+		return;
 	}
-	
+
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_EnemyHealthBarUpdate);
+
+	struct FHealthBarCandidate
+	{
+		AEnemy* Enemy;
+		FVector2D Position;
+		float Priority;
+	};
+	TArray<FHealthBarCandidate, TInlineAllocator<16>> Candidates;
+
+	FMatrix ViewProjection;
+	FIntRect ViewRect;
+	APawn* ViewPawn = GetPawn();
+	const AMain* Main = Cast<AMain>(ViewPawn);
+	if (ViewPawn && GetViewProjection(ViewProjection, ViewRect))
+	{
+		const FVector ViewerLocation = ViewPawn->GetActorLocation();
+		const AEnemy* CombatTarget = (Main && bEnemyHealthBarVisible) ? Main->CombatTarget : nullptr;
+		const float CullDistanceSquared = FMath::Square(EnemyHealthBarCullDistance);
+		const bool bCombatTargetOnly = ShowsCombatTargetOnly();
+
+		for (const TWeakObjectPtr<AEnemy>& Enemy : EngagedEnemies)
+		{
+			// Over any other enemy the bar would show the combat target's health, or none
+			if (bCombatTargetOnly && Enemy.Get() != CombatTarget)
+			{
+				continue;
+			}
+
+			const FVector TargetLocation = Enemy->GetActorLocation();
+			const float DistanceSquared = FVector::DistSquared(ViewerLocation, TargetLocation);
+			if (DistanceSquared > CullDistanceSquared)
+			{
+				continue;
+			}
+
+			FVector2D Position;
+			if (!FSceneView::ProjectWorldToScreen(TargetLocation, ViewRect, ViewProjection, Position))
+			{
+				continue;
+			}
+			Position.Y -= 100.0f;
+
+			if (Position.X < ViewRect.Min.X || Position.X > ViewRect.Max.X || Position.Y < ViewRect.Min.Y || Position.Y > ViewRect.Max.Y)
+			{
+				continue;
+			}
+
+			// Combat target first, then nearest
+			Candidates.Add({ Enemy.Get(), Position, Enemy.Get() == CombatTarget ? -1.f : DistanceSquared });
+		}
+	}
+
+	const int32 Limit = GetEnemyHealthBarLimit();
+	if (Candidates.Num() > Limit)
+	{
+		Candidates.Sort([](const FHealthBarCandidate& A, const FHealthBarCandidate& B) { return A.Priority < B.Priority; });
+		Candidates.SetNum(Limit, false);
+	}
+
+	// Bars whose enemy was culled go back to the pool before new ones are handed out
+	for (int32 Index = ActiveHealthBars.Num() - 1; Index >= 0; --Index)
+	{
+		AEnemy* Enemy = ActiveHealthBars[Index].Enemy.Get();
+		if (!Candidates.ContainsByPredicate([Enemy](const FHealthBarCandidate& Candidate) { return Candidate.Enemy == Enemy; }))
+		{
+			ReleaseEnemyHealthBar(Index);
+		}
+	}
+
+	EnemyHealthBar = nullptr;
+
+	for (const FHealthBarCandidate& Candidate : Candidates)
+	{
+		FActiveEnemyHealthBar* Bar = ActiveHealthBars.FindByPredicate([&Candidate](const FActiveEnemyHealthBar& Active) { return Active.Enemy.Get() == Candidate.Enemy; });
+		if (!Bar)
+		{
+			UUserWidget* Widget = AcquireEnemyHealthBar();
+			if (!Widget)
+			{
+				break;
+			}
+
+			if (UEnemyHealthBarWidget* EnemyWidget = Cast<UEnemyHealthBarWidget>(Widget))
+			{
+				EnemyWidget->SetEnemy(Candidate.Enemy);
+			}
+			Widget->SetPositionInViewport(Candidate.Position);
+			Widget->SetVisibility(ESlateVisibility::Visible);
+
+			Bar = &ActiveHealthBars.AddDefaulted_GetRef();
+			Bar->Enemy = Candidate.Enemy;
+			Bar->Widget = Widget;
+			Bar->LastPosition = Candidate.Position;
+		}
+		// Moving the bar invalidates its layout, skip sub-threshold jitter
+		else if (FVector2D::DistSquared(Candidate.Position, Bar->LastPosition) > FMath::Square(HealthBarMoveThreshold))
+		{
+			Bar->Widget->SetPositionInViewport(Candidate.Position);
+			Bar->LastPosition = Candidate.Position;
+		}
+
+		if (Main && Candidate.Enemy == Main->CombatTarget)
+		{
+			EnemyHealthBar = Bar->Widget;
+		}
+	}
+}
+
+bool AMainPlayerController::GetViewProjection(FMatrix& OutViewProjection, FIntRect& OutViewRect) const
+{
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	GetViewportSize(SizeX, SizeY);
+	if (!PlayerCameraManager || SizeX <= 0 || SizeY <= 0)
+	{
+		return false;
+	}
+
+	FMinimalViewInfo ViewInfo = PlayerCameraManager->GetCameraCachePOV();
+	ViewInfo.AspectRatio = static_cast<float>(SizeX) / SizeY;
+	ViewInfo.bConstrainAspectRatio = false;
+
+	FMatrix ViewMatrix;
+	FMatrix ProjectionMatrix;
+	UGameplayStatics::GetViewProjectionMatrix(ViewInfo, ViewMatrix, ProjectionMatrix, OutViewProjection);
+	OutViewRect = FIntRect(0, 0, SizeX, SizeY);
+	return true;
+}
+
+UUserWidget* AMainPlayerController::AcquireEnemyHealthBar()
+{
+	if (FreeEnemyHealthBars.Num() > 0)
+	{
+		return FreeEnemyHealthBars.Pop(false);
+	}
+	return CreateEnemyHealthBar();
+}
+
+UUserWidget* AMainPlayerController::CreateEnemyHealthBar()
+{
+	if (!WEnemyHealthBar || EnemyHealthBarPool.Num() >= GetEnemyHealthBarLimit())
+	{
+		return nullptr;
+	}
+
+	FIRSTPROJECT_LLM_SCOPE(EFirstProjectLLMTag::HUDWidgets);
+	UUserWidget* Widget = CreateWidget<UUserWidget>(this, WEnemyHealthBar);
+	if (Widget)
+	{
+		Widget->AddToViewport();
+		Widget->SetAlignmentInViewport(FVector2D(0.f));
+		Widget->SetDesiredSizeInViewport(FVector2D(250.0f, 25.0f));
+		EnemyHealthBarPool.Add(Widget);
+	}
+	return Widget;
+}
+
+bool AMainPlayerController::ShowsCombatTargetOnly() const
+{
+	return WEnemyHealthBar && !WEnemyHealthBar->IsChildOf<UEnemyHealthBarWidget>();
+}
+
+int32 AMainPlayerController::GetEnemyHealthBarLimit() const
+{
+	// More than one bar bound to the combat target would all show it
+	if (ShowsCombatTargetOnly())
+	{
+		return FMath::Min(MaxEnemyHealthBars, 1);
+	}
+	return FMath::Max(MaxEnemyHealthBars, 0);
+}
+
+void AMainPlayerController::ReleaseEnemyHealthBar(int32 ActiveIndex)
+{
+	UUserWidget* Widget = ActiveHealthBars[ActiveIndex].Widget;
+	// Collapsed bars take no part in layout while they wait in the pool
+	Widget->SetVisibility(ESlateVisibility::Collapsed);
+	if (UEnemyHealthBarWidget* EnemyWidget = Cast<UEnemyHealthBarWidget>(Widget))
+	{
+		EnemyWidget->SetEnemy(nullptr);
+	}
+	FreeEnemyHealthBars.Add(Widget);
+	ActiveHealthBars.RemoveAtSwap(ActiveIndex, 1, false);
 }
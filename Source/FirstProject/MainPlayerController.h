@@ -6,6 +6,16 @@
 #include "GameFramework/PlayerController.h"
 #include "MainPlayerController.generated.h"
 
+/** Enemy health bar taken from the pool, and where it was last placed */
+struct FActiveEnemyHealthBar
+{
+	TWeakObjectPtr<class AEnemy> Enemy;
+
+	class UUserWidget* Widget;
+
+	FVector2D LastPosition;
+};
+
 /**
  * 
  */
@@ -16,6 +26,8 @@ class FIRSTPROJECT_API AMainPlayerController : public APlayerController
 
 public:
 
+	AMainPlayerController();
+
 	/** Reference to the UMG asset in the editor */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Widgets")
 	TSubclassOf<class UUserWidget> HUDOverlayAsset;
@@ -27,22 +39,60 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Widgets")
 	TSubclassOf<UUserWidget> WEnemyHealthBar;
 
+	/** Bar currently shown over the player's combat target, null if it has none */
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Widgets")
 	UUserWidget* EnemyHealthBar;
 
+	/** Most enemy health bars on screen at once, the pool never grows past this. One unless WEnemyHealthBar derives from UEnemyHealthBarWidget */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Widgets")
+	int32 MaxEnemyHealthBars;
+
+	/** Enemies further than this from the player don't get a health bar */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Widgets")
+	float EnemyHealthBarCullDistance;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Widgets")
 	TSubclassOf<UUserWidget> WPauseMenu;
 
+	/** Created the first time the menu opens, unless prewarmed */
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Widgets")
 	UUserWidget* PauseMenu;
 
+	/** Create the pause menu and the enemy health bar pool in BeginPlay instead of on first use */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Widgets")
+	bool bPrewarmWidgets;
+
+	/** Create every widget the controller can show, e.g. while a loading screen is up */
+	UFUNCTION(BlueprintCallable, Category = "Widgets")
+	void PrewarmWidgets();
+
 	bool bEnemyHealthBarVisible;
 
+	/** Screen distance in pixels the health bar's target has to move before the bar is repositioned */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Widgets")
+	float HealthBarMoveThreshold;
+
+	/**
+	 * Wrap the HUD overlay's widget tree in an invalidation box so unchanged widgets are not laid out and painted every frame.
+	 * Property bindings don't invalidate the box, so only turn this on once the HUD reads from UHUDViewModel
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Widgets")
+	bool bCacheHUDLayout;
+
 	void DisplayEnemyHealthBar();
 	void RemoveEnemyHealthBar();
 
+	/** Show a health bar over the enemy while it is on screen and in range */
+	void AddEngagedEnemy(AEnemy* Enemy);
+
+	void RemoveEngagedEnemy(AEnemy* Enemy);
+
 	bool bPauseMenuVisible;
 
+	/** Frame rate cap while the pause menu has the world paused, zero leaves the frame rate alone */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "HUD")
+	float PausedMaxFPS;
+
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "HUD")
 	void DisplayPauseMenu();
 	
@@ -59,7 +109,52 @@ protected:
 
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	virtual void Tick(float DeltaSeconds) override;
-	
+
+private:
+
+	/** Session wide instance of WidgetClass, shared with the controllers of later levels */
+	UUserWidget* GetCachedWidget(TSubclassOf<UUserWidget> WidgetClass);
+
+	/** Pause menu, created and added to the viewport hidden on first call */
+	UUserWidget* GetPauseMenu();
+
+	void UpdateEnemyHealthBars();
+
+	void SetPausedFrameRateCap(bool bPaused);
+
+	/** Frame rate cap to restore on unpause */
+	float UnpausedMaxFPS;
+
+	bool bFrameRateCapped;
+
+	/** View projection of the player camera for this frame, false if there is nothing to project onto */
+	bool GetViewProjection(FMatrix& OutViewProjection, FIntRect& OutViewRect) const;
+
+	UUserWidget* AcquireEnemyHealthBar();
+
+	/** Bars that don't derive from UEnemyHealthBarWidget bind to the player's combat target, whichever enemy they sit over */
+	bool ShowsCombatTargetOnly() const;
+
+	/** MaxEnemyHealthBars, capped at one for bars that can only show the combat target */
+	int32 GetEnemyHealthBarLimit() const;
+
+	/** New pooled bar, added to the viewport. Null once the pool is full */
+	UUserWidget* CreateEnemyHealthBar();
+
+	void ReleaseEnemyHealthBar(int32 ActiveIndex);
+
+	TArray<TWeakObjectPtr<AEnemy>> EngagedEnemies;
+
+	TArray<FActiveEnemyHealthBar> ActiveHealthBars;
+
+	/** Every bar the pool created, keeps them alive while hidden */
+	UPROPERTY()
+	TArray<UUserWidget*> EnemyHealthBarPool;
+
+	UPROPERTY()
+	TArray<UUserWidget*> FreeEnemyHealthBars;
 	
 };
@@ -0,0 +1,359 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FirstProject.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Main.h"
+#include "Enemy.h"
+#include "SpawnVolume.h"
+#include "Item.h"
+#include "Weapon.h"
+#include "Explosive.h"
+#include "FirstSaveGame.h"
+#include "TestWorld.h"
+#include "Dom/JsonObject.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+static TAutoConsoleVariable<float> CVarMicrobenchmarkTolerance(
+	TEXT("FirstProject.Microbenchmarks.Tolerance"),
+	0.1f,
+	TEXT("Fraction a benchmark may get slower than its baseline before it is reported as a regression"));
+
+namespace Microbenchmarks
+{
+	/** Untimed passes before the timed ones, for caches, allocators and lazy initialization */
+	const int32 WarmupRuns = 1;
+
+	/** Timed passes, the median one is reported */
+	const int32 TimedRuns = 5;
+
+	const TCHAR* const LatestName = TEXT("Latest");
+
+	const TCHAR* const BaselineName = TEXT("Baseline");
+
+	/** Slot the save benchmark writes and deletes again, so the player's slots are never touched */
+	const TCHAR* const SaveSlotName = TEXT("Microbenchmark");
+
+	FString GetPath(const FString& Name)
+	{
+		return FPaths::ProjectSavedDir() / TEXT("Microbenchmarks") / Name + TEXT(".json");
+	}
+
+	/** Benchmarks of a result file by name */
+	TMap<FString, TSharedPtr<FJsonObject>> Load(const FString& Path)
+	{
+		TMap<FString, TSharedPtr<FJsonObject>> Benchmarks;
+
+		FString Json;
+		TSharedPtr<FJsonObject> Root;
+		if (FFileHelper::LoadFileToString(Json, *Path) && FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Root) && Root.IsValid())
+		{
+			const TArray<TSharedPtr<FJsonValue>>* Values = nullptr;
+			if (Root->TryGetArrayField(TEXT("Benchmarks"), Values))
+			{
+				for (const TSharedPtr<FJsonValue>& Value : *Values)
+				{
+					const TSharedPtr<FJsonObject> Benchmark = Value->AsObject();
+					Benchmarks.Add(Benchmark->GetStringField(TEXT("Name")), Benchmark);
+				}
+			}
+		}
+		return Benchmarks;
+	}
+
+	void Save(const FString& Path, TMap<FString, TSharedPtr<FJsonObject>>& Benchmarks)
+	{
+		Benchmarks.KeySort(TLess<FString>());
+
+		int32 NumRegressions = 0;
+		TArray<TSharedPtr<FJsonValue>> Values;
+		for (const TPair<FString, TSharedPtr<FJsonObject>>& Benchmark : Benchmarks)
+		{
+			bool bRegressed = false;
+			NumRegressions += Benchmark.Value->TryGetBoolField(TEXT("Regressed"), bRegressed) && bRegressed;
+			Values.Add(MakeShared<FJsonValueObject>(Benchmark.Value));
+		}
+
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetStringField(TEXT("Timestamp"), FDateTime::UtcNow().ToIso8601());
+		Root->SetStringField(TEXT("Baseline"), BaselineName);
+		Root->SetNumberField(TEXT("Regressions"), NumRegressions);
+		Root->SetArrayField(TEXT("Benchmarks"), Values);
+
+		FString Json;
+		FJsonSerializer::Serialize(Root, TJsonWriterFactory<>::Create(&Json));
+		FFileHelper::SaveStringToFile(Json, *Path);
+	}
+
+	/**
+	 * Time Iterations calls of Function, after Setup has put back whatever the previous pass changed.
+	 * Returns the seconds of the median timed pass.
+	 */
+	template <typename SetupType, typename FunctionType>
+	double TimeMedian(int32 Iterations, SetupType&& Setup, FunctionType&& Function)
+	{
+		TArray<double> Seconds;
+		for (int32 Run = -WarmupRuns; Run < TimedRuns; ++Run)
+		{
+			Setup();
+
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				Function(Iteration);
+			}
+			const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+			if (Run >= 0)
+			{
+				Seconds.Add(Elapsed);
+			}
+		}
+		Seconds.Sort();
+		return Seconds[Seconds.Num() / 2];
+	}
+
+	template <typename FunctionType>
+	double TimeMedian(int32 Iterations, FunctionType&& Function)
+	{
+		return TimeMedian(Iterations, []() {}, Forward<FunctionType>(Function));
+	}
+
+	/**
+	 * Compare a result with Saved/Microbenchmarks/Baseline.json and merge it into Latest.json.
+	 * A regression beyond the tolerance fails the test. The baseline takes the result when it has none for
+	 * this benchmark yet, or when the run was started with -UpdateMicrobenchmarkBaseline.
+	 */
+	void Report(FAutomationTestBase& Test, const FString& Name, int32 Iterations, double Seconds)
+	{
+		const double Nanoseconds = Seconds * 1e9 / FMath::Max(Iterations, 1);
+
+		TSharedRef<FJsonObject> Benchmark = MakeShared<FJsonObject>();
+		Benchmark->SetStringField(TEXT("Name"), Name);
+		Benchmark->SetNumberField(TEXT("Iterations"), Iterations);
+		Benchmark->SetNumberField(TEXT("Runs"), TimedRuns);
+		Benchmark->SetNumberField(TEXT("TotalMs"), Seconds * 1000.0);
+		Benchmark->SetNumberField(TEXT("NsPerIteration"), Nanoseconds);
+
+		const FString BaselinePath = GetPath(BaselineName);
+		TMap<FString, TSharedPtr<FJsonObject>> Baseline = Load(BaselinePath);
+		const TSharedPtr<FJsonObject>* BaselineBenchmark = Baseline.Find(Name);
+		const double BaselineNanoseconds = BaselineBenchmark ? (*BaselineBenchmark)->GetNumberField(TEXT("NsPerIteration")) : 0.0;
+		if (BaselineNanoseconds > 0.0)
+		{
+			const float Tolerance = CVarMicrobenchmarkTolerance.GetValueOnGameThread();
+			const double Change = Nanoseconds / BaselineNanoseconds - 1.0;
+			const bool bRegressed = Change > Tolerance;
+
+			Benchmark->SetNumberField(TEXT("BaselineNsPerIteration"), BaselineNanoseconds);
+			Benchmark->SetNumberField(TEXT("Change"), Change);
+			Benchmark->SetBoolField(TEXT("Regressed"), bRegressed);
+
+			const FString Message = FString::Printf(TEXT("%s: %.1f ns, baseline %.1f ns, %+.1f%%"), *Name, Nanoseconds, BaselineNanoseconds, Change * 100.0);
+			if (bRegressed)
+			{
+				Test.AddError(FString::Printf(TEXT("%s, more than %.0f%% slower"), *Message, Tolerance * 100.f));
+			}
+			else
+			{
+				Test.AddInfo(Message);
+			}
+		}
+		else
+		{
+			Test.AddInfo(FString::Printf(TEXT("%s: %.1f ns, no baseline"), *Name, Nanoseconds));
+		}
+		UE_LOG(LogFirstProject, Display, TEXT("%s: %.1f ns per iteration"), *Name, Nanoseconds);
+
+		const FString LatestPath = GetPath(LatestName);
+		TMap<FString, TSharedPtr<FJsonObject>> Latest = Load(LatestPath);
+		Latest.Add(Name, Benchmark);
+		Save(LatestPath, Latest);
+
+		if (!BaselineBenchmark || FParse::Param(FCommandLine::Get(), TEXT("UpdateMicrobenchmarkBaseline")))
+		{
+			Baseline.Add(Name, Benchmark);
+			Save(BaselinePath, Baseline);
+		}
+	}
+
+	/** Enemies need BeginPlay for their overlap bindings and live count */
+	AEnemy* SpawnEnemy(FFirstProjectTestWorld& TestWorld, const FVector& Location)
+	{
+		AEnemy* Enemy = TestWorld.Spawn<AEnemy>(FTransform(Location));
+		Enemy->DispatchBeginPlay();
+		return Enemy;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMainUpdateStaminaBenchmark, "FirstProject.Performance.Main.UpdateStamina",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+/** One simulated frame per iteration, toggling sprint often enough to walk every stamina state */
+bool FMainUpdateStaminaBenchmark::RunTest(const FString& Parameters)
+{
+	FFirstProjectTestWorld TestWorld(TEXT("MainUpdateStaminaBenchmark"));
+	AMain* Main = TestWorld.Spawn<AMain>();
+	Main->bMovingForward = true;
+
+	const int32 Iterations = 1000000;
+	const double Seconds = Microbenchmarks::TimeMedian(Iterations,
+		[Main]()
+		{
+			Main->Stamina = Main->MaxStamina;
+		},
+		[Main](int32 Frame)
+		{
+			Main->bShiftKeyDown = (Frame / 600) % 2 == 0;
+			Main->UpdateStamina(1.f / 60.f);
+		});
+
+	Microbenchmarks::Report(*this, TEXT("Main.UpdateStamina"), Iterations, Seconds);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMainUpdateCombatTargetBenchmark, "FirstProject.Performance.Main.UpdateCombatTarget",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+/** Enemies are placed inside the agro radius so every one of them overlaps the player */
+bool FMainUpdateCombatTargetBenchmark::RunTest(const FString& Parameters)
+{
+	FFirstProjectTestWorld TestWorld(TEXT("MainUpdateCombatTargetBenchmark"));
+	AMain* Main = TestWorld.Spawn<AMain>();
+
+	const int32 EnemyCounts[] = { 1, 10, 100, 1000 };
+	const int32 Iterations = 1000;
+
+	FRandomStream Random(1);
+	TArray<AEnemy*> Enemies;
+	for (int32 EnemyCount : EnemyCounts)
+	{
+		while (Enemies.Num() < EnemyCount)
+		{
+			Enemies.Add(Microbenchmarks::SpawnEnemy(TestWorld, Random.GetUnitVector() * Random.FRandRange(100.f, 400.f)));
+		}
+		Main->UpdateOverlaps(false);
+
+		TArray<AActor*> Overlapping;
+		Main->GetOverlappingActors(Overlapping, AEnemy::StaticClass());
+		TestEqual(FString::Printf(TEXT("Enemies overlapping the player out of %d"), EnemyCount), Overlapping.Num(), EnemyCount);
+
+		const double Seconds = Microbenchmarks::TimeMedian(Iterations, [Main](int32)
+		{
+			Main->UpdateCombatTarget();
+		});
+		Microbenchmarks::Report(*this, FString::Printf(TEXT("Main.UpdateCombatTarget.%d"), EnemyCount), Iterations, Seconds);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEnemyTakeDamageBenchmark, "FirstProject.Performance.Enemy.TakeDamage",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+/** Three hits per enemy, the last one kills it. Enemies are spread out of the player's reach, so the combat target update after each kill finds nothing */
+bool FEnemyTakeDamageBenchmark::RunTest(const FString& Parameters)
+{
+	FFirstProjectTestWorld TestWorld(TEXT("EnemyTakeDamageBenchmark"));
+	AMain* Main = TestWorld.Spawn<AMain>();
+
+	const int32 NumEnemies = 1000;
+	const int32 HitsPerEnemy = 3;
+
+	// Every pass kills all of them, so each one starts with a fresh set
+	TArray<AEnemy*> Enemies;
+	auto RespawnEnemies = [&]()
+	{
+		for (AEnemy* Enemy : Enemies)
+		{
+			Enemy->Destroy();
+		}
+		Enemies.Reset();
+		for (int32 Index = 0; Index < NumEnemies; ++Index)
+		{
+			AEnemy* Enemy = Microbenchmarks::SpawnEnemy(TestWorld, FVector(5000.f + (Index % 32) * 2000.f, (Index / 32) * 2000.f, 0.f));
+			Enemy->Health = Enemy->MaxHealth;
+			Enemies.Add(Enemy);
+		}
+	};
+
+	const float Damage = FMath::CeilToFloat(GetDefault<AEnemy>()->MaxHealth / HitsPerEnemy);
+	const FDamageEvent DamageEvent;
+	const double Seconds = Microbenchmarks::TimeMedian(NumEnemies * HitsPerEnemy, RespawnEnemies, [&](int32 Hit)
+	{
+		Enemies[Hit / HitsPerEnemy]->TakeDamage(Damage, DamageEvent, nullptr, Main);
+	});
+
+	Microbenchmarks::Report(*this, TEXT("Enemy.TakeDamage"), NumEnemies * HitsPerEnemy, Seconds);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSpawnVolumeBenchmark, "FirstProject.Performance.SpawnVolume",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FSpawnVolumeBenchmark::RunTest(const FString& Parameters)
+{
+	FFirstProjectTestWorld TestWorld(TEXT("SpawnVolumeBenchmark"));
+	ASpawnVolume* Volume = TestWorld.Spawn<ASpawnVolume>();
+	Volume->SpawnArray = { AEnemy::StaticClass(), AItem::StaticClass(), AWeapon::StaticClass(), AExplosive::StaticClass() };
+
+	const int32 Iterations = 1000000;
+
+	FVector Sum = FVector::ZeroVector;
+	const double PointSeconds = Microbenchmarks::TimeMedian(Iterations, [&](int32)
+	{
+		Sum += Volume->GetSpawnPoint();
+	});
+	Microbenchmarks::Report(*this, TEXT("SpawnVolume.GetSpawnPoint"), Iterations, PointSeconds);
+
+	int32 Selected = 0;
+	const double ActorSeconds = Microbenchmarks::TimeMedian(Iterations, [&](int32)
+	{
+		Selected += Volume->GetSpawnActor() != nullptr;
+	});
+	Microbenchmarks::Report(*this, TEXT("SpawnVolume.GetSpawnActor"), Iterations, ActorSeconds);
+
+	// Keeps the sampled values alive so the loops can't be optimized away
+	UE_LOG(LogFirstProject, Verbose, TEXT("Spawn volume samples: %s, %d"), *Sum.ToString(), Selected);
+	TestEqual(TEXT("Spawn actors selected"), Selected, Iterations * (Microbenchmarks::WarmupRuns + Microbenchmarks::TimedRuns));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSaveSlotRoundTripBenchmark, "FirstProject.Performance.SaveGame.WriteReadSlot",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+/** Capture, write and read back the player's state through a slot of its own, deleted again afterwards */
+bool FSaveSlotRoundTripBenchmark::RunTest(const FString& Parameters)
+{
+	FFirstProjectTestWorld TestWorld(TEXT("SaveSlotRoundTripBenchmark"));
+	AMain* Main = TestWorld.Spawn<AMain>();
+
+	const int32 UserIndex = GetDefault<UFirstSaveGame>()->UserIndex;
+	const int32 Iterations = 20;
+
+	bool bRoundTripped = true;
+	const double Seconds = Microbenchmarks::TimeMedian(Iterations, [&](int32)
+	{
+		FSaveGameData Data;
+		Main->CaptureSaveData(Data);
+		FSaveGameData Loaded;
+		bRoundTripped &= UFirstSaveGame::WriteSlot(Data, Microbenchmarks::SaveSlotName, UserIndex)
+			&& UFirstSaveGame::ReadSlot(Microbenchmarks::SaveSlotName, UserIndex, Loaded);
+	});
+
+	TestTrue(TEXT("Slot written and read back"), bRoundTripped);
+	TestTrue(TEXT("Benchmark slot deleted"), UFirstSaveGame::DeleteSlot(Microbenchmarks::SaveSlotName, UserIndex));
+
+	Microbenchmarks::Report(*this, TEXT("SaveGame.WriteReadSlot"), Iterations, Seconds);
+	return true;
+}
+
+#endif
@@ -0,0 +1,244 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PerformanceSubsystem.h"
+#include "FirstProject.h"
+#include "Enemy.h"
+#include "SpawnVolume.h"
+#include "Debug/DebugDrawService.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Particles/ParticleSystemComponent.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Emitters"), STAT_LiveEmitters, STATGROUP_FirstProject);
+
+namespace PerformanceOverlay
+{
+	/** Frames kept for the rolling percentiles, ten seconds at 60 fps */
+	const int32 WindowSize = 600;
+
+	/** Percentiles are re-sorted this often, not every frame */
+	const int32 RefreshFrames = 15;
+}
+
+UPerformanceSubsystem::UPerformanceSubsystem()
+{
+	NextFrameTime = 0;
+	LastFrameSeconds = 0.0;
+	Percentile50 = 0.f;
+	Percentile90 = 0.f;
+	Percentile99 = 0.f;
+	MaxFrameTime = 0.f;
+	FramesUntilPercentiles = 0;
+}
+
+void UPerformanceSubsystem::NotifyEmitterSpawned(const UObject* WorldContextObject, UParticleSystemComponent* Emitter)
+{
+	CSV_CUSTOM_STAT(FirstProject, EmittersSpawned, 1, ECsvCustomStatOp::Accumulate);
+
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	UPerformanceSubsystem* Performance = World ? World->GetSubsystem<UPerformanceSubsystem>() : nullptr;
+	if (Performance && Emitter)
+	{
+		// The subsystem doesn't always tick, so emitters destroyed before finishing are also dropped here
+		Performance->PruneEmitters();
+
+		Performance->ActiveEmitters.Add(Emitter);
+		INC_DWORD_STAT(STAT_LiveEmitters);
+		Emitter->OnSystemFinished.AddUniqueDynamic(Performance, &UPerformanceSubsystem::OnEmitterFinished);
+	}
+}
+
+void UPerformanceSubsystem::OnEmitterFinished(UParticleSystemComponent* Emitter)
+{
+	const int32 Index = ActiveEmitters.IndexOfByKey(Emitter);
+	if (Index != INDEX_NONE)
+	{
+		ActiveEmitters.RemoveAtSwap(Index, 1, false);
+		DEC_DWORD_STAT(STAT_LiveEmitters);
+	}
+}
+
+void UPerformanceSubsystem::PruneEmitters()
+{
+	const int32 NumEmitters = ActiveEmitters.Num();
+	ActiveEmitters.RemoveAllSwap([](const TWeakObjectPtr<UParticleSystemComponent>& Emitter)
+	{
+		return !Emitter.IsValid() || !Emitter->IsActive();
+	}, false);
+	DEC_DWORD_STAT_BY(STAT_LiveEmitters, NumEmitters - ActiveEmitters.Num());
+}
+
+bool UPerformanceSubsystem::IsCsvCapturing()
+{
+#if CSV_PROFILER
+	return FCsvProfiler::Get()->IsCapturing();
+#else
+	return false;
+#endif
+}
+
+void UPerformanceSubsystem::Tick(float DeltaTime)
+{
+	PruneEmitters();
+
+	RecordGameplayStats();
+
+	if (!IsOverlayEnabled())
+	{
+		return;
+	}
+
+	// Wall clock, so the overlay shows hitches the game clock would hide while paused or time dilated
+	const double Now = FPlatformTime::Seconds();
+	if (LastFrameSeconds > 0.0)
+	{
+		const float FrameMilliseconds = static_cast<float>((Now - LastFrameSeconds) * 1000.0);
+		if (FrameTimes.Num() < PerformanceOverlay::WindowSize)
+		{
+			FrameTimes.Add(FrameMilliseconds);
+		}
+		else
+		{
+			FrameTimes[NextFrameTime] = FrameMilliseconds;
+		}
+		NextFrameTime = (NextFrameTime + 1) % PerformanceOverlay::WindowSize;
+	}
+	LastFrameSeconds = Now;
+
+	if (--FramesUntilPercentiles <= 0)
+	{
+		UpdatePercentiles();
+		FramesUntilPercentiles = PerformanceOverlay::RefreshFrames;
+	}
+}
+
+void UPerformanceSubsystem::RecordGameplayStats()
+{
+#if CSV_PROFILER
+	if (!IsCsvCapturing())
+	{
+		return;
+	}
+
+	int32 EnemiesByStatus[(int32)EEnemyMovementStatus::EMS_Max] = {};
+	for (TActorIterator<AEnemy> It(GetWorld()); It; ++It)
+	{
+		++EnemiesByStatus[(int32)It->GetEnemyMovementStatus()];
+	}
+	CSV_CUSTOM_STAT(FirstProject, EnemiesIdle, EnemiesByStatus[(int32)EEnemyMovementStatus::EMS_Idle], ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(FirstProject, EnemiesMoveToTarget, EnemiesByStatus[(int32)EEnemyMovementStatus::EMS_MoveToTarget], ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(FirstProject, EnemiesAttacking, EnemiesByStatus[(int32)EEnemyMovementStatus::EMS_Attacking], ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(FirstProject, EnemiesDead, EnemiesByStatus[(int32)EEnemyMovementStatus::EMS_Dead], ECsvCustomStatOp::Set);
+
+	int32 PendingSpawns = 0;
+	for (TActorIterator<ASpawnVolume> It(GetWorld()); It; ++It)
+	{
+		PendingSpawns += It->DormantRecords.Num();
+	}
+	CSV_CUSTOM_STAT(FirstProject, PendingSpawns, PendingSpawns, ECsvCustomStatOp::Set);
+
+	CSV_CUSTOM_STAT(FirstProject, ActiveEmitters, ActiveEmitters.Num(), ECsvCustomStatOp::Set);
+#endif
+}
+
+void UPerformanceSubsystem::UpdatePercentiles()
+{
+	if (FrameTimes.Num() == 0)
+	{
+		return;
+	}
+
+	SortedFrameTimes = FrameTimes;
+	SortedFrameTimes.Sort();
+
+	const int32 Last = SortedFrameTimes.Num() - 1;
+	Percentile50 = SortedFrameTimes[FMath::RoundToInt(Last * 0.5f)];
+	Percentile90 = SortedFrameTimes[FMath::RoundToInt(Last * 0.9f)];
+	Percentile99 = SortedFrameTimes[FMath::RoundToInt(Last * 0.99f)];
+	MaxFrameTime = SortedFrameTimes[Last];
+}
+
+void UPerformanceSubsystem::SetOverlayEnabled(bool bEnabled)
+{
+	if (bEnabled && !OverlayHandle.IsValid())
+	{
+		FrameTimes.Reset(PerformanceOverlay::WindowSize);
+		NextFrameTime = 0;
+		LastFrameSeconds = 0.0;
+		FramesUntilPercentiles = 0;
+		OverlayHandle = UDebugDrawService::Register(TEXT("Game"), FDebugDrawDelegate::CreateUObject(this, &UPerformanceSubsystem::DrawOverlay));
+	}
+	else if (!bEnabled && OverlayHandle.IsValid())
+	{
+		UDebugDrawService::Unregister(OverlayHandle);
+		OverlayHandle.Reset();
+	}
+}
+
+void UPerformanceSubsystem::DrawOverlay(UCanvas* Canvas, APlayerController* PlayerController)
+{
+	if (!Canvas || !GEngine || (PlayerController && PlayerController->GetWorld() != GetWorld()))
+	{
+		return;
+	}
+
+	const FString Text = FString::Printf(TEXT("Frame ms  p50 %.2f  p90 %.2f  p99 %.2f  max %.2f  (%d frames)"),
+		Percentile50, Percentile90, Percentile99, MaxFrameTime, FrameTimes.Num());
+
+	Canvas->SetDrawColor(FColor::White);
+	Canvas->DrawText(GEngine->GetSmallFont(), Text, 20.f, Canvas->ClipY - 40.f);
+}
+
+void UPerformanceSubsystem::Deinitialize()
+{
+	SetOverlayEnabled(false);
+
+	DEC_DWORD_STAT_BY(STAT_LiveEmitters, ActiveEmitters.Num());
+	ActiveEmitters.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UPerformanceSubsystem::IsTickable() const
+{
+	return IsOverlayEnabled() || IsCsvCapturing();
+}
+
+bool UPerformanceSubsystem::IsTickableWhenPaused() const
+{
+	return true;
+}
+
+ETickableTickType UPerformanceSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* UPerformanceSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UPerformanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPerformanceSubsystem, STATGROUP_Tickables);
+}
+
+#if FIRSTPROJECT_DEBUG_TOOLS
+
+static FAutoConsoleCommandWithWorld PerfOverlayCommand(
+	TEXT("FirstProject.PerfOverlay"),
+	TEXT("Toggle the rolling frame time percentile overlay"),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		UPerformanceSubsystem* Performance = World ? World->GetSubsystem<UPerformanceSubsystem>() : nullptr;
+		if (Performance)
+		{
+			Performance->SetOverlayEnabled(!Performance->IsOverlayEnabled());
+		}
+	}));
+
+#endif
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "PerformanceSubsystem.generated.h"
+
+/**
+ * Per frame gameplay metrics for the CSV profiler and the frame time overlay.
+ * Run with -csvCaptureFrames=N, or csvprofile start / stop, to write the FirstProject category to Saved/Profiling/CSV.
+ */
+UCLASS()
+class FIRSTPROJECT_API UPerformanceSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UPerformanceSubsystem();
+
+	/** Count an emitter spawned by gameplay code, it stays in the Live Emitters stat until it finishes or is destroyed */
+	static void NotifyEmitterSpawned(const UObject* WorldContextObject, class UParticleSystemComponent* Emitter);
+
+	void SetOverlayEnabled(bool bEnabled);
+
+	FORCEINLINE bool IsOverlayEnabled() const { return OverlayHandle.IsValid(); }
+
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual bool IsTickableWhenPaused() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	static bool IsCsvCapturing();
+
+	UFUNCTION()
+	void OnEmitterFinished(UParticleSystemComponent* Emitter);
+
+	/** Drop emitters destroyed without finishing, or deactivated */
+	void PruneEmitters();
+
+	void RecordGameplayStats();
+
+	void UpdatePercentiles();
+
+	void DrawOverlay(class UCanvas* Canvas, class APlayerController* PlayerController);
+
+	TArray<TWeakObjectPtr<UParticleSystemComponent>> ActiveEmitters;
+
+	/** Ring buffer of the last frame times in milliseconds */
+	TArray<float> FrameTimes;
+	int32 NextFrameTime;
+
+	double LastFrameSeconds;
+
+	/** Reused when sorting frame times */
+	TArray<float> SortedFrameTimes;
+
+	float Percentile50;
+	float Percentile90;
+	float Percentile99;
+	float MaxFrameTime;
+
+	int32 FramesUntilPercentiles;
+
+	FDelegateHandle OverlayHandle;
+};
@@ -2,15 +2,59 @@
 
 
 #include "Pickup.h"
+#include "FirstProject.h"
+#include "PerformanceSubsystem.h"
 #include "Main.h"
 #include "Kismet/GameplayStatics.h"
 #include "Engine/World.h"
 #include "Sound/SoundCue.h"
 #include "Particles/ParticleSystemComponent.h"
+#include "Components/SphereComponent.h"
+#include "PickupSubsystem.h"
+#include "WorldStateSubsystem.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Live Pickups"), STAT_LivePickups, STATGROUP_FirstProject);
 
 APickup::APickup()
 {
-	
+	bInstancedMesh = true;
+	bGridCollection = true;
+	GridCell = FIntPoint(INDEX_NONE, INDEX_NONE);
+}
+
+void APickup::BeginPlay()
+{
+	Super::BeginPlay();
+
+	INC_DWORD_STAT(STAT_LivePickups);
+
+	if (bGridCollection)
+	{
+		UPickupSubsystem* Pickups = GetWorld()->GetSubsystem<UPickupSubsystem>();
+		if (Pickups)
+		{
+			Pickups->RegisterPickup(this);
+
+			// The grid does the overlap test, drop the sphere's physics body from the broadphase
+			CollisionVolume->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		}
+	}
+}
+
+void APickup::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (GridCell != FIntPoint(INDEX_NONE, INDEX_NONE))
+	{
+		UPickupSubsystem* Pickups = GetWorld()->GetSubsystem<UPickupSubsystem>();
+		if (Pickups)
+		{
+			Pickups->UnregisterPickup(this);
+		}
+	}
+
+	DEC_DWORD_STAT(STAT_LivePickups);
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void APickup::OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
@@ -24,22 +68,29 @@ void APickup::OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* O
 		AMain* Main = Cast<AMain>(OtherActor);
 		if(Main)
 		{
-			OnPickupBP(Main);
-			Main->PickUpLocations.Add(GetActorLocation());
-
-			if(OverlapParticles)
-			{
-				UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), OverlapParticles, GetActorLocation(), FRotator(0.f), true);
-			}
-			if(OverlapSound)
-			{
-				UGameplayStatics::PlaySound2D(this, OverlapSound);
-			}			
-			Destroy();
+			Collect(Main);
 		}
 	}	
 }
 
+void APickup::Collect(AMain* Main)
+{
+	OnPickupBP(Main);
+	Main->PickupHistory.Add(GetActorLocation(), GetWorld()->GetTimeSeconds(), GetClass()->GetFName());
+	UWorldStateSubsystem::MarkConsumed(this, WorldStateId);
+
+	if(OverlapParticles)
+	{
+		UParticleSystemComponent* Emitter = UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), OverlapParticles, GetActorLocation(), FRotator(0.f), true);
+		UPerformanceSubsystem::NotifyEmitterSpawned(this, Emitter);
+	}
+	if(OverlapSound)
+	{
+		UGameplayStatics::PlaySound2D(this, OverlapSound);
+	}			
+	Destroy();
+}
+
 void APickup::OnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp,
 	int32 OtherBodyIndex)
 {
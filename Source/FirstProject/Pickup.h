@@ -18,6 +18,13 @@ public:
 
 	APickup();
 
+	/** Collect through the pickup grid instead of this actor's own overlap sphere */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Pickup")
+	bool bGridCollection;
+
+	/** Cell in the pickup grid, (INDEX_NONE, INDEX_NONE) when not registered */
+	FIntPoint GridCell;
+
 	virtual void OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
 		UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult) override;
 
@@ -26,5 +33,14 @@ public:
 
 	UFUNCTION(BlueprintImplementableEvent, Category = "Pickup")
 	void OnPickupBP(class AMain* Target);
+
+	/** Give the pickup to the player, play effects and destroy it */
+	void Collect(AMain* Main);
+
+protected:
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	
 };
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PickupHistory.h"
+#include "FirstProject.h"
+#include "Main.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+FPickupHistory::FPickupHistory(int32 InCapacity)
+	: Capacity(FMath::Max(InCapacity, 1))
+	, Oldest(0)
+{
+	Entries.Reserve(Capacity);
+}
+
+void FPickupHistory::SetCapacity(int32 NewCapacity)
+{
+	NewCapacity = FMath::Max(NewCapacity, 1);
+	if (NewCapacity == Capacity)
+	{
+		return;
+	}
+
+	TArray<FPickupHistoryEntry> Kept;
+	Kept.Reserve(NewCapacity);
+	for (int32 Index = FMath::Max(Entries.Num() - NewCapacity, 0); Index < Entries.Num(); ++Index)
+	{
+		Kept.Add((*this)[Index]);
+	}
+
+	Entries = MoveTemp(Kept);
+	Capacity = NewCapacity;
+	Oldest = 0;
+}
+
+void FPickupHistory::Add(const FVector& Location, float Time, FName ItemType)
+{
+	if (Entries.Num() < Capacity)
+	{
+		Entries.Add({ Location, Time, ItemType });
+	}
+	else
+	{
+		Entries[Oldest] = { Location, Time, ItemType };
+		Oldest = (Oldest + 1) % Capacity;
+	}
+}
+
+void FPickupHistory::Reset()
+{
+	Entries.Reset();
+	Oldest = 0;
+}
+
+bool FPickupHistory::ExportCsv(const FString& Path) const
+{
+	FString Csv = TEXT("Time,X,Y,Z,ItemType\n");
+	for (int32 Index = 0; Index < Entries.Num(); ++Index)
+	{
+		const FPickupHistoryEntry& Entry = (*this)[Index];
+		Csv += FString::Printf(TEXT("%.2f,%.1f,%.1f,%.1f,%s\n"), Entry.Time, Entry.Location.X, Entry.Location.Y, Entry.Location.Z, *Entry.ItemType.ToString());
+	}
+	return FFileHelper::SaveStringToFile(Csv, *Path);
+}
+
+#if FIRSTPROJECT_DEBUG_TOOLS
+
+static FAutoConsoleCommandWithWorldAndArgs ExportPickupHistoryCommand(
+	TEXT("FirstProject.ExportPickupHistory"),
+	TEXT("Write the player's recent pickups to Saved/PickupHistory/<Name>.csv. Usage: FirstProject.ExportPickupHistory [Name=PickupHistory]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		AMain* Main = World ? Cast<AMain>(UGameplayStatics::GetPlayerPawn(World, 0)) : nullptr;
+		if (!Main)
+		{
+			return;
+		}
+
+		const FString Path = FPaths::ProjectSavedDir() / TEXT("PickupHistory") / (Args.Num() > 0 ? Args[0] : TEXT("PickupHistory")) + TEXT(".csv");
+		if (Main->PickupHistory.ExportCsv(Path))
+		{
+			UE_LOG(LogFirstProject, Log, TEXT("Exported %d pickups to %s"), Main->PickupHistory.Num(), *Path);
+		}
+	}));
+
+#endif
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Where and when the player collected something */
+struct FPickupHistoryEntry
+{
+	FVector Location;
+
+	/** World time of the pickup in seconds */
+	float Time;
+
+	/** Class name of the collected item */
+	FName ItemType;
+};
+
+/**
+ * The most recent pickups in a fixed capacity ring buffer.
+ * Storage is allocated once, the oldest entry is overwritten when full, so a long session doesn't grow it.
+ */
+class FIRSTPROJECT_API FPickupHistory
+{
+public:
+
+	explicit FPickupHistory(int32 InCapacity = 256);
+
+	/** Change the capacity, keeping the newest entries that still fit */
+	void SetCapacity(int32 NewCapacity);
+
+	FORCEINLINE int32 GetCapacity() const { return Capacity; }
+
+	FORCEINLINE int32 Num() const { return Entries.Num(); }
+
+	void Add(const FVector& Location, float Time, FName ItemType);
+
+	/** Entry by age, 0 is the oldest kept */
+	FORCEINLINE const FPickupHistoryEntry& operator[](int32 Index) const
+	{
+		return Entries[(Oldest + Index) % Entries.Num()];
+	}
+
+	void Reset();
+
+	/** Write the entries oldest first as Time,X,Y,Z,ItemType rows, for heatmaps */
+	bool ExportCsv(const FString& Path) const;
+
+private:
+
+	TArray<FPickupHistoryEntry> Entries;
+
+	int32 Capacity;
+
+	/** Slot of the oldest entry, only moves once the buffer is full */
+	int32 Oldest;
+};
@@ -0,0 +1,222 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PickupManager.h"
+#include "Item.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/World.h"
+
+APickupManager::APickupManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// Only needed once a rotating item registers
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("RootComponent"));
+
+	NumRotatingItems = 0;
+}
+
+void APickupManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	for (FPickupBatch& Batch : Batches)
+	{
+		if (Batch.RotationRate == 0.f || Batch.Items.Num() == 0)
+		{
+			continue;
+		}
+
+		const float Yaw = GetSpinYaw(Batch);
+
+		ScratchTransforms.SetNum(Batch.Items.Num(), false);
+		for (int32 Index = 0; Index < Batch.Items.Num(); ++Index)
+		{
+			ScratchTransforms[Index] = GetInstanceTransform(Batch, Index, Yaw);
+		}
+
+		Batch.Instances->BatchUpdateInstancesTransforms(0, ScratchTransforms, true, true, true);
+	}
+}
+
+void APickupManager::RegisterItem(AItem* Item)
+{
+	if (!Item || !Item->Mesh || Item->PickupInstanceIndex != INDEX_NONE)
+	{
+		return;
+	}
+
+	FPickupBatchKey Key;
+	Key.Mesh = Item->Mesh->GetStaticMesh();
+	for (int32 MaterialIndex = 0; MaterialIndex < Item->Mesh->GetNumMaterials(); ++MaterialIndex)
+	{
+		Key.Materials.Add(Item->Mesh->GetMaterial(MaterialIndex));
+	}
+	Key.RotationRate = Item->bRotate ? Item->RotationRate : 0.f;
+	Key.bCastShadow = Item->Mesh->CastShadow;
+
+	if (!Key.Mesh)
+	{
+		return;
+	}
+
+	const FTransform ItemTransform = Item->GetActorTransform();
+	AddInstance(FindOrAddBatch(Key), Item, ItemTransform, Item->Mesh->GetComponentTransform().GetRelativeTransform(ItemTransform));
+	Item->Mesh->SetVisibility(false);
+}
+
+void APickupManager::UnregisterItem(AItem* Item)
+{
+	if (!Item || !Batches.IsValidIndex(Item->PickupBatchIndex))
+	{
+		return;
+	}
+
+	FPickupBatch& Batch = Batches[Item->PickupBatchIndex];
+	const int32 Slot = Item->PickupInstanceIndex;
+	if (!Batch.Items.IsValidIndex(Slot) || Batch.Items[Slot] != Item)
+	{
+		return;
+	}
+
+	RemoveInstance(Batch, Slot);
+
+	Item->PickupBatchIndex = INDEX_NONE;
+	Item->PickupInstanceIndex = INDEX_NONE;
+	if (Item->Mesh)
+	{
+		Item->Mesh->SetVisibility(true);
+	}
+}
+
+void APickupManager::UpdateItemRotation(AItem* Item)
+{
+	if (!Item || !Batches.IsValidIndex(Item->PickupBatchIndex))
+	{
+		return;
+	}
+
+	const int32 Slot = Item->PickupInstanceIndex;
+	FPickupBatchKey Key = Batches[Item->PickupBatchIndex].Key;
+	Key.RotationRate = Item->bRotate ? Item->RotationRate : 0.f;
+	if (Key.RotationRate == Batches[Item->PickupBatchIndex].RotationRate || !Batches[Item->PickupBatchIndex].Items.IsValidIndex(Slot))
+	{
+		return;
+	}
+
+	// The item's own mesh may already be destroyed, so it moves with the transforms it registered with
+	const int32 NewBatchIndex = FindOrAddBatch(Key);
+	FPickupBatch& Batch = Batches[Item->PickupBatchIndex];
+	const FTransform ItemTransform = Batch.ItemTransforms[Slot];
+	const FTransform MeshOffset = Batch.MeshOffsets[Slot];
+	RemoveInstance(Batch, Slot);
+	AddInstance(NewBatchIndex, Item, ItemTransform, MeshOffset);
+}
+
+int32 APickupManager::FindOrAddBatch(const FPickupBatchKey& Key)
+{
+	if (const int32* FoundBatch = BatchLookup.Find(Key))
+	{
+		return *FoundBatch;
+	}
+
+	// Every transform update rebuilds a hierarchical component's cluster tree, so spinning batches skip it
+	UInstancedStaticMeshComponent* Instances = Key.RotationRate != 0.f
+		? NewObject<UInstancedStaticMeshComponent>(this)
+		: NewObject<UHierarchicalInstancedStaticMeshComponent>(this);
+	Instances->SetStaticMesh(Key.Mesh);
+	for (int32 MaterialIndex = 0; MaterialIndex < Key.Materials.Num(); ++MaterialIndex)
+	{
+		Instances->SetMaterial(MaterialIndex, Key.Materials[MaterialIndex]);
+	}
+	Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Instances->SetCastShadow(Key.bCastShadow);
+	Instances->SetupAttachment(RootComponent);
+	Instances->RegisterComponent();
+
+	const int32 BatchIndex = Batches.AddDefaulted();
+	Batches[BatchIndex].Instances = Instances;
+	Batches[BatchIndex].RotationRate = Key.RotationRate;
+	Batches[BatchIndex].Key = Key;
+	BatchLookup.Add(Key, BatchIndex);
+	return BatchIndex;
+}
+
+int32 APickupManager::AddInstance(int32 BatchIndex, AItem* Item, const FTransform& ItemTransform, const FTransform& MeshOffset)
+{
+	FPickupBatch& Batch = Batches[BatchIndex];
+	Batch.Items.Add(Item);
+	Batch.ItemTransforms.Add(ItemTransform);
+	Batch.MeshOffsets.Add(MeshOffset);
+
+	const int32 InstanceIndex = Batch.Items.Num() - 1;
+	Batch.Instances->AddInstanceWorldSpace(GetInstanceTransform(Batch, InstanceIndex, GetSpinYaw(Batch)));
+
+	Item->PickupBatchIndex = BatchIndex;
+	Item->PickupInstanceIndex = InstanceIndex;
+
+	if (Batch.RotationRate != 0.f)
+	{
+		++NumRotatingItems;
+		SetActorTickEnabled(true);
+	}
+	return InstanceIndex;
+}
+
+void APickupManager::RemoveInstance(FPickupBatch& Batch, int32 Slot)
+{
+	const int32 Last = Batch.Items.Num() - 1;
+	if (Slot != Last)
+	{
+		// Keep instances packed by moving the last one into the hole
+		Batch.Items[Slot] = Batch.Items[Last];
+		Batch.ItemTransforms[Slot] = Batch.ItemTransforms[Last];
+		Batch.MeshOffsets[Slot] = Batch.MeshOffsets[Last];
+		Batch.Items[Slot]->PickupInstanceIndex = Slot;
+
+		Batch.Instances->UpdateInstanceTransform(Slot, GetInstanceTransform(Batch, Slot, GetSpinYaw(Batch)), true, false, true);
+	}
+
+	Batch.Instances->RemoveInstance(Last);
+	Batch.Items.RemoveAt(Last, 1, false);
+	Batch.ItemTransforms.RemoveAt(Last, 1, false);
+	Batch.MeshOffsets.RemoveAt(Last, 1, false);
+
+	if (Batch.RotationRate != 0.f)
+	{
+		--NumRotatingItems;
+		if (NumRotatingItems == 0)
+		{
+			SetActorTickEnabled(false);
+		}
+	}
+}
+
+int32 APickupManager::GetNumInstances() const
+{
+	int32 NumInstances = 0;
+	for (const FPickupBatch& Batch : Batches)
+	{
+		NumInstances += Batch.Items.Num();
+	}
+	return NumInstances;
+}
+
+FTransform APickupManager::GetInstanceTransform(const FPickupBatch& Batch, int32 Index, float Yaw) const
+{
+	FTransform ItemTransform = Batch.ItemTransforms[Index];
+	if (Batch.RotationRate != 0.f)
+	{
+		// Same world yaw spin AItem::Tick applies to the actor
+		ItemTransform.SetRotation(FQuat(FVector::UpVector, FMath::DegreesToRadians(Yaw)) * ItemTransform.GetRotation());
+	}
+	return Batch.MeshOffsets[Index] * ItemTransform;
+}
+
+float APickupManager::GetSpinYaw(const FPickupBatch& Batch) const
+{
+	const UWorld* World = GetWorld();
+	return World ? FMath::Fmod(World->GetTimeSeconds() * Batch.RotationRate, 360.f) : 0.f;
+}
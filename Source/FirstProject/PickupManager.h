@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "PickupManager.generated.h"
+
+/** Identifies items that can be drawn by the same instanced mesh component */
+struct FPickupBatchKey
+{
+	class UStaticMesh* Mesh;
+
+	/** Material of every slot, overrides included */
+	TArray<class UMaterialInterface*, TInlineAllocator<4>> Materials;
+
+	/** Degrees per second, zero for items that don't spin */
+	float RotationRate;
+
+	bool bCastShadow;
+
+	bool operator==(const FPickupBatchKey& Other) const
+	{
+		return Mesh == Other.Mesh && Materials == Other.Materials && RotationRate == Other.RotationRate && bCastShadow == Other.bCastShadow;
+	}
+
+	friend uint32 GetTypeHash(const FPickupBatchKey& Key)
+	{
+		uint32 Hash = HashCombine(GetTypeHash(Key.Mesh), GetTypeHash(Key.RotationRate));
+		for (const UMaterialInterface* Material : Key.Materials)
+		{
+			Hash = HashCombine(Hash, GetTypeHash(Material));
+		}
+		return HashCombine(Hash, GetTypeHash(Key.bCastShadow));
+	}
+};
+
+USTRUCT()
+struct FPickupBatch
+{
+	GENERATED_BODY()
+
+	/** Hierarchical for batches that never move, plain for spinning ones, which would rebuild the cluster tree every frame */
+	UPROPERTY()
+	class UInstancedStaticMeshComponent* Instances;
+
+	/** Item drawn by each instance, indexed like the instances */
+	UPROPERTY()
+	TArray<class AItem*> Items;
+
+	/** Mesh transform relative to its item */
+	TArray<FTransform> MeshOffsets;
+
+	/** Item transform at registration, before any spin */
+	TArray<FTransform> ItemTransforms;
+
+	float RotationRate;
+
+	/** Key the batch was created for, so items can move between batches after their own mesh is gone */
+	FPickupBatchKey Key;
+
+	FPickupBatch()
+		: Instances(nullptr)
+		, RotationRate(0.f)
+	{
+	}
+};
+
+/**
+ * Draws identical items through one instanced mesh per batch, hierarchical for items that don't spin,
+ * and spins all rotating ones from a single tick, so the items themselves never tick.
+ */
+UCLASS(NotPlaceable, Transient)
+class FIRSTPROJECT_API APickupManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	APickupManager();
+
+	virtual void Tick(float DeltaTime) override;
+
+	/** Hide the item's own mesh and draw it as an instance instead */
+	void RegisterItem(AItem* Item);
+
+	/** Remove the item's instance, moving the last instance of its batch into the freed slot */
+	void UnregisterItem(AItem* Item);
+
+	/** Move the item to the batch spinning at its current rotation settings */
+	void UpdateItemRotation(AItem* Item);
+
+	int32 GetNumInstances() const;
+
+private:
+
+	int32 FindOrAddBatch(const FPickupBatchKey& Key);
+
+	/** Add an instance for the item to the batch, returns its index */
+	int32 AddInstance(int32 BatchIndex, AItem* Item, const FTransform& ItemTransform, const FTransform& MeshOffset);
+
+	/** Free a slot, shared by unregistering and moving items between batches */
+	void RemoveInstance(FPickupBatch& Batch, int32 Slot);
+
+	FTransform GetInstanceTransform(const FPickupBatch& Batch, int32 Index, float Yaw) const;
+
+	float GetSpinYaw(const FPickupBatch& Batch) const;
+
+	UPROPERTY()
+	TArray<FPickupBatch> Batches;
+
+	TMap<FPickupBatchKey, int32> BatchLookup;
+
+	/** Reused every tick to avoid reallocating the transform array */
+	TArray<FTransform> ScratchTransforms;
+
+	int32 NumRotatingItems;
+};
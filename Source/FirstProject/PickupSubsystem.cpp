@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PickupSubsystem.h"
+#include "FirstProject.h"
+#include "PickupManager.h"
+#include "Item.h"
+#include "Pickup.h"
+#include "Main.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SphereComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+
+UPickupSubsystem::UPickupSubsystem()
+{
+	CellSize = 500.f;
+	MaxPickupRadius = 0.f;
+	NumGridPickups = 0;
+	LastQueryCandidates = 0;
+	LastQuerySeconds = 0.0;
+}
+
+APickupManager* UPickupSubsystem::GetPickupManager()
+{
+	if (!PickupManager || PickupManager->IsPendingKill())
+	{
+		UWorld* World = GetWorld();
+		if (World)
+		{
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.ObjectFlags |= RF_Transient;
+			PickupManager = World->SpawnActor<APickupManager>(SpawnParams);
+		}
+	}
+	return PickupManager;
+}
+
+void UPickupSubsystem::RegisterPickup(APickup* Pickup)
+{
+	if (!Pickup || Pickup->GridCell != FIntPoint(INDEX_NONE, INDEX_NONE))
+	{
+		return;
+	}
+
+	Pickup->GridCell = GetCell(Pickup->GetActorLocation());
+	Grid.FindOrAdd(Pickup->GridCell).Add(Pickup);
+	MaxPickupRadius = FMath::Max(MaxPickupRadius, Pickup->CollisionVolume->GetScaledSphereRadius());
+	++NumGridPickups;
+}
+
+void UPickupSubsystem::UnregisterPickup(APickup* Pickup)
+{
+	if (!Pickup || Pickup->GridCell == FIntPoint(INDEX_NONE, INDEX_NONE))
+	{
+		return;
+	}
+
+	TArray<APickup*>* Cell = Grid.Find(Pickup->GridCell);
+	if (Cell && Cell->RemoveSingleSwap(Pickup, false) > 0)
+	{
+		--NumGridPickups;
+		if (Cell->Num() == 0)
+		{
+			Grid.Remove(Pickup->GridCell);
+		}
+	}
+	Pickup->GridCell = FIntPoint(INDEX_NONE, INDEX_NONE);
+}
+
+void UPickupSubsystem::Tick(float DeltaTime)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	LastQueryCandidates = 0;
+
+	UWorld* World = GetWorld();
+	for (FConstPlayerControllerIterator Iterator = World->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		APlayerController* PlayerController = Iterator->Get();
+		AMain* Main = PlayerController ? Cast<AMain>(PlayerController->GetPawn()) : nullptr;
+		if (Main)
+		{
+			CollectAround(Main);
+		}
+	}
+
+	LastQuerySeconds = FPlatformTime::Seconds() - StartTime;
+}
+
+bool UPickupSubsystem::IsTickable() const
+{
+	return NumGridPickups > 0;
+}
+
+ETickableTickType UPickupSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* UPickupSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UPickupSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPickupSubsystem, STATGROUP_Tickables);
+}
+
+FIntPoint UPickupSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void UPickupSubsystem::CollectAround(AMain* Main)
+{
+	const UCapsuleComponent* Capsule = Main->GetCapsuleComponent();
+	const float CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+	const FVector Center = Capsule->GetComponentLocation();
+	const FVector Axis = Capsule->GetUpVector() * Capsule->GetScaledCapsuleHalfHeight_WithoutHemisphere();
+	const FVector SegmentStart = Center - Axis;
+	const FVector SegmentEnd = Center + Axis;
+
+	const float Reach = CapsuleRadius + MaxPickupRadius + Axis.Size2D();
+	const FIntPoint MinCell = GetCell(Center - FVector(Reach));
+	const FIntPoint MaxCell = GetCell(Center + FVector(Reach));
+
+	TArray<APickup*, TInlineAllocator<8>> Collected;
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			const TArray<APickup*>* Cell = Grid.Find(FIntPoint(X, Y));
+			if (!Cell)
+			{
+				continue;
+			}
+
+			for (APickup* Pickup : *Cell)
+			{
+				++LastQueryCandidates;
+
+				const FVector PickupLocation = Pickup->GetActorLocation();
+				const FVector Closest = FMath::ClosestPointOnSegment(PickupLocation, SegmentStart, SegmentEnd);
+				const float CollectRadius = CapsuleRadius + Pickup->CollisionVolume->GetScaledSphereRadius();
+				if (FVector::DistSquared(Closest, PickupLocation) <= FMath::Square(CollectRadius))
+				{
+					Collected.Add(Pickup);
+				}
+			}
+		}
+	}
+
+	// Collecting destroys the pickup, which edits the grid, so do it after the walk
+	for (APickup* Pickup : Collected)
+	{
+		Pickup->Collect(Main);
+	}
+}
+
+#if FIRSTPROJECT_DEBUG_TOOLS
+
+/** Benchmark helper: fill the area in front of the player with a square grid of items */
+static FAutoConsoleCommandWithWorldAndArgs SpawnPickupFieldCommand(
+	TEXT("FirstProject.SpawnPickupField"),
+	TEXT("Spawn a grid of items around the player. Usage: FirstProject.SpawnPickupField <ClassPath> [Count=5000] [Spacing=150]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World || Args.Num() < 1)
+		{
+			return;
+		}
+
+		UClass* ItemClass = LoadClass<AItem>(nullptr, *Args[0]);
+		APawn* Player = UGameplayStatics::GetPlayerPawn(World, 0);
+		if (!ItemClass || !Player)
+		{
+			return;
+		}
+
+		const int32 Count = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 5000;
+		const float Spacing = Args.Num() > 2 ? FCString::Atof(*Args[2]) : 150.f;
+		const int32 Side = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(Count)));
+		const FVector Origin = Player->GetActorLocation() + Player->GetActorForwardVector() * 300.f;
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			const FVector Location = Origin + FVector((Index / Side) * Spacing, (Index % Side - Side / 2) * Spacing, 0.f);
+			World->SpawnActor<AItem>(ItemClass, Location, FRotator(0.f), SpawnParams);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld PickupGridStatsCommand(
+	TEXT("FirstProject.PickupGridStats"),
+	TEXT("Log pickup grid occupancy and the cost of the last collection query"),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		UPickupSubsystem* Pickups = World ? World->GetSubsystem<UPickupSubsystem>() : nullptr;
+		if (Pickups)
+		{
+			UE_LOG(LogFirstProject, Log, TEXT("Pickup grid: %d pickups in %d cells (%d sphere bodies not created), last query tested %d pickups in %.3f ms"),
+				Pickups->GetNumGridPickups(), Pickups->GetNumGridCells(), Pickups->GetNumGridPickups(),
+				Pickups->GetLastQueryCandidates(), Pickups->GetLastQuerySeconds() * 1000.0);
+		}
+	}));
+
+#endif
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "PickupSubsystem.generated.h"
+
+/**
+ * Per world owner of the shared pickup systems.
+ * Pickups live in a static 2D grid and are collected by testing the player's capsule
+ * against nearby cells once per frame, so they don't need physics bodies of their own.
+ */
+UCLASS()
+class FIRSTPROJECT_API UPickupSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UPickupSubsystem();
+
+	/** Manager drawing instanced items, spawned on first use */
+	class APickupManager* GetPickupManager();
+
+	/** Manager drawing instanced items, or null if nothing registered yet */
+	FORCEINLINE APickupManager* FindPickupManager() const { return PickupManager; }
+
+	/** Add a pickup to the collection grid. It must not move while registered */
+	void RegisterPickup(class APickup* Pickup);
+
+	void UnregisterPickup(APickup* Pickup);
+
+	FORCEINLINE int32 GetNumGridPickups() const { return NumGridPickups; }
+	FORCEINLINE int32 GetNumGridCells() const { return Grid.Num(); }
+
+	/** Pickups distance tested during the last frame */
+	FORCEINLINE int32 GetLastQueryCandidates() const { return LastQueryCandidates; }
+
+	FORCEINLINE double GetLastQuerySeconds() const { return LastQuerySeconds; }
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	void CollectAround(class AMain* Main);
+
+	UPROPERTY()
+	APickupManager* PickupManager;
+
+	/** Grid cell size in world units */
+	float CellSize;
+
+	/** Largest collect radius registered, used to pad the capsule query */
+	float MaxPickupRadius;
+
+	/** Pickups remove themselves in EndPlay, so entries are always live */
+	TMap<FIntPoint, TArray<APickup*>> Grid;
+
+	int32 NumGridPickups;
+
+	int32 LastQueryCandidates;
+
+	double LastQuerySeconds;
+};
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlatformSubsystem.h"
+#include "FirstProject.h"
+#include "FloatingPlatform.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Floating Platforms Update"), STAT_FloatingPlatformsUpdate, STATGROUP_FirstProject);
+
+void UPlatformSubsystem::RegisterPlatform(AFloatingPlatform* Platform)
+{
+	Platforms.AddUnique(Platform);
+}
+
+void UPlatformSubsystem::UnregisterPlatform(AFloatingPlatform* Platform)
+{
+	Platforms.RemoveSingleSwap(Platform, false);
+}
+
+void UPlatformSubsystem::Tick(float DeltaTime)
+{
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_FloatingPlatformsUpdate);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	for (AFloatingPlatform* Platform : Platforms)
+	{
+		if (!Platform->bInterping && Now < Platform->NextMoveTime)
+		{
+			continue;
+		}
+
+		bool bMoving = false;
+		float PhaseEnd = 0.f;
+		const FVector Location = Platform->GetLocationAtTime(Now, bMoving, PhaseEnd);
+
+		// Kinematic move without a sweep; characters based on the platform follow it through their movement base
+		Platform->SetActorLocation(Location, false, nullptr, ETeleportType::None);
+
+		Platform->bInterping = bMoving;
+		if (!bMoving)
+		{
+			Platform->NextMoveTime = PhaseEnd;
+		}
+	}
+}
+
+bool UPlatformSubsystem::IsTickable() const
+{
+	return Platforms.Num() > 0;
+}
+
+ETickableTickType UPlatformSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* UPlatformSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UPlatformSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPlatformSubsystem, STATGROUP_Tickables);
+}
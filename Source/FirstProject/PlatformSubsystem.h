@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "PlatformSubsystem.generated.h"
+
+/**
+ * Moves every floating platform from one tick.
+ * Resting platforms are skipped until their next leg starts.
+ */
+UCLASS()
+class FIRSTPROJECT_API UPlatformSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	void RegisterPlatform(class AFloatingPlatform* Platform);
+
+	void UnregisterPlatform(AFloatingPlatform* Platform);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	/** Platforms unregister in EndPlay, so entries are always live */
+	TArray<AFloatingPlatform*> Platforms;
+};
@@ -0,0 +1,475 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ReplaySubsystem.h"
+#include "FirstProject.h"
+#include "Main.h"
+#include "Enemy.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/InputSettings.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+/** Bumped whenever the capture layout or the recorded axes and actions change */
+static const int32 CaptureVersion = 2;
+
+static TAutoConsoleVariable<int32> CVarRandomSeed(
+	TEXT("FirstProject.RandomSeed"),
+	0,
+	TEXT("Seed for gameplay randomness when no capture is running, 0 picks a new seed for every world"));
+
+// Must match the bindings in AMain::SetupPlayerInputComponent.
+// ESC is left out, the pause menu doesn't change the simulation and would stop the replay.
+const FName UReplaySubsystem::AxisNames[] = { TEXT("MoveForward"), TEXT("MoveRight"), TEXT("Turn"), TEXT("LookUp"), TEXT("TurnRate"), TEXT("LookUpRate") };
+const FName UReplaySubsystem::ActionNames[] = { TEXT("Jump"), TEXT("Sprint"), TEXT("LMB") };
+
+UReplaySubsystem::UReplaySubsystem()
+{
+	Mode = EMode::None;
+	bStarted = false;
+	Seed = 0;
+	ReplayIndex = 0;
+	LastFrameTime = 0.0;
+	bPreviousUseFixedTimeStep = false;
+	PreviousFixedDeltaTime = 0.0;
+}
+
+FRandomStream& UReplaySubsystem::GetRandomStream(EGameplayRandom Stream)
+{
+	EnsureStarted();
+	return Streams[(int32)Stream];
+}
+
+FRandomStream& UReplaySubsystem::GetWorldRandom(const UObject* WorldContextObject, EGameplayRandom Stream)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	UReplaySubsystem* Replay = World ? World->GetSubsystem<UReplaySubsystem>() : nullptr;
+	if (Replay)
+	{
+		return Replay->GetRandomStream(Stream);
+	}
+
+	static FRandomStream Fallback(0);
+	return Fallback;
+}
+
+void UReplaySubsystem::EnsureStarted()
+{
+	if (bStarted)
+	{
+		return;
+	}
+	bStarted = true;
+
+	const int32 ConfiguredSeed = CVarRandomSeed.GetValueOnGameThread();
+	Reseed(ConfiguredSeed != 0 ? ConfiguredSeed : static_cast<int32>(FPlatformTime::Cycles()));
+
+	const UWorld* World = GetWorld();
+	if (World && World->IsGameWorld())
+	{
+		if (const TCHAR* RecordName = World->URL.GetOption(TEXT("RecordInput="), nullptr))
+		{
+			StartRecording(RecordName);
+		}
+		else if (const TCHAR* ReplayName = World->URL.GetOption(TEXT("ReplayInput="), nullptr))
+		{
+			StartReplay(ReplayName);
+		}
+	}
+}
+
+void UReplaySubsystem::Reseed(int32 NewSeed)
+{
+	Seed = NewSeed;
+	for (int32 Index = 0; Index < (int32)EGameplayRandom::Count; ++Index)
+	{
+		// Separate streams so an extra roll in one system doesn't shift every other one
+		Streams[Index].Initialize(static_cast<int32>(HashCombine(static_cast<uint32>(Seed), static_cast<uint32>(Index))));
+	}
+}
+
+void UReplaySubsystem::StartRecording(const FString& NewCaptureName)
+{
+	Stop();
+	bStarted = true;
+
+	CaptureName = NewCaptureName;
+	Frames.Reset();
+	Reseed(static_cast<int32>(FPlatformTime::Cycles()));
+
+	ActionKeys.Reset();
+	const UInputSettings* InputSettings = UInputSettings::GetInputSettings();
+	for (const FName& ActionName : ActionNames)
+	{
+		TArray<FInputActionKeyMapping> Mappings;
+		InputSettings->GetActionMappingByName(ActionName, Mappings);
+
+		TArray<FKey>& Keys = ActionKeys.AddDefaulted_GetRef();
+		for (const FInputActionKeyMapping& Mapping : Mappings)
+		{
+			Keys.Add(Mapping.Key);
+		}
+	}
+
+	// Recording runs in real time, each frame's delta is stored instead
+	Mode = EMode::Recording;
+	UE_LOG(LogFirstProject, Log, TEXT("Recording input capture '%s' with seed %d"), *CaptureName, Seed);
+}
+
+void UReplaySubsystem::StartReplay(const FString& NewCaptureName)
+{
+	Stop();
+	bStarted = true;
+
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *GetCapturePath(NewCaptureName, TEXT("capture"))))
+	{
+		UE_LOG(LogFirstProject, Warning, TEXT("Input capture '%s' not found"), *NewCaptureName);
+		return;
+	}
+
+	FMemoryReader Reader(Data);
+	int32 Version = 0;
+	Reader << Version;
+	if (Version != CaptureVersion)
+	{
+		UE_LOG(LogFirstProject, Warning, TEXT("Input capture '%s' has version %d, expected %d"), *NewCaptureName, Version, CaptureVersion);
+		return;
+	}
+
+	int32 CaptureSeed = 0;
+	Reader << CaptureSeed << Frames;
+
+	CaptureName = NewCaptureName;
+	ReplayIndex = 0;
+	FrameHashes.Reset(Frames.Num());
+	FrameMilliseconds.Reset(Frames.Num());
+	LastFrameTime = FPlatformTime::Seconds();
+	Reseed(CaptureSeed);
+
+	SetFixedTimestep(true);
+	Mode = EMode::Replaying;
+	UE_LOG(LogFirstProject, Log, TEXT("Replaying input capture '%s', %d frames"), *CaptureName, Frames.Num());
+}
+
+void UReplaySubsystem::Stop()
+{
+	if (Mode == EMode::Recording)
+	{
+		TArray<uint8> Data;
+		FMemoryWriter Writer(Data);
+		int32 Version = CaptureVersion;
+		Writer << Version << Seed << Frames;
+
+		const FString Path = GetCapturePath(CaptureName, TEXT("capture"));
+		FFileHelper::SaveArrayToFile(Data, *Path);
+		UE_LOG(LogFirstProject, Log, TEXT("Saved input capture '%s', %d frames"), *Path, Frames.Num());
+	}
+	else if (Mode == EMode::Replaying)
+	{
+		WriteReplayReport();
+
+		APlayerController* PlayerController = ReplayPawn.IsValid() ? Cast<APlayerController>(ReplayPawn->GetController()) : nullptr;
+		if (PlayerController)
+		{
+			ReplayPawn->EnableInput(PlayerController);
+		}
+		ReplayPawn.Reset();
+	}
+
+	if (Mode == EMode::Replaying)
+	{
+		SetFixedTimestep(false);
+	}
+	Mode = EMode::None;
+	Frames.Empty();
+}
+
+void UReplaySubsystem::SetFixedTimestep(bool bEnable)
+{
+	if (bEnable)
+	{
+		bPreviousUseFixedTimeStep = FApp::UseFixedTimeStep();
+		PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+		FApp::SetFixedDeltaTime(Frames.Num() > 0 ? Frames[0].DeltaTime : PreviousFixedDeltaTime);
+		FApp::SetUseFixedTimeStep(true);
+	}
+	else
+	{
+		FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+		FApp::SetUseFixedTimeStep(bPreviousUseFixedTimeStep);
+	}
+}
+
+void UReplaySubsystem::ProcessPlayerInput(AMain* Main)
+{
+	if (Mode == EMode::Recording)
+	{
+		RecordFrame(Main);
+	}
+	else if (Mode == EMode::Replaying)
+	{
+		ReplayFrame(Main);
+	}
+}
+
+void UReplaySubsystem::RecordFrame(AMain* Main)
+{
+	APlayerController* PlayerController = Cast<APlayerController>(Main->GetController());
+	if (!PlayerController || !Main->InputComponent)
+	{
+		return;
+	}
+
+	FInputCaptureFrame& Frame = Frames.AddDefaulted_GetRef();
+	Frame.DeltaTime = FApp::GetDeltaTime();
+	for (const FName& AxisName : AxisNames)
+	{
+		// Value the binding handed to AMain this frame
+		Frame.Axes.Add(Main->InputComponent->GetAxisValue(AxisName));
+	}
+
+	for (int32 Action = 0; Action < ActionKeys.Num(); ++Action)
+	{
+		for (const FKey& Key : ActionKeys[Action])
+		{
+			if (PlayerController->WasInputKeyJustPressed(Key))
+			{
+				Frame.Pressed |= 1u << Action;
+			}
+			if (PlayerController->WasInputKeyJustReleased(Key))
+			{
+				Frame.Released |= 1u << Action;
+			}
+		}
+	}
+}
+
+void UReplaySubsystem::ReplayFrame(AMain* Main)
+{
+	if (!ReplayPawn.IsValid())
+	{
+		// Live input would be applied on top of the recording
+		APlayerController* PlayerController = Cast<APlayerController>(Main->GetController());
+		if (PlayerController)
+		{
+			Main->DisableInput(PlayerController);
+		}
+		ReplayPawn = Main;
+	}
+
+	if (!Frames.IsValidIndex(ReplayIndex))
+	{
+		return;
+	}
+
+	const FInputCaptureFrame& Frame = Frames[ReplayIndex++];
+	// The engine reads the fixed delta when it starts the next frame
+	if (Frames.IsValidIndex(ReplayIndex))
+	{
+		FApp::SetFixedDeltaTime(Frames[ReplayIndex].DeltaTime);
+	}
+	if (Frame.Axes.Num() == UE_ARRAY_COUNT(AxisNames))
+	{
+		Main->MoveForwrd(Frame.Axes[0]);
+		Main->MoveRight(Frame.Axes[1]);
+		Main->Turn(Frame.Axes[2]);
+		Main->LookUp(Frame.Axes[3]);
+		Main->TurnAtRate(Frame.Axes[4]);
+		Main->LookUpAtRate(Frame.Axes[5]);
+	}
+
+	// Same order as ActionNames
+	if (Frame.Pressed & (1u << 0)) { Main->Jump(); }
+	if (Frame.Released & (1u << 0)) { Main->StopJumping(); }
+	if (Frame.Pressed & (1u << 1)) { Main->ShiftKeyDown(); }
+	if (Frame.Released & (1u << 1)) { Main->ShiftKeyUp(); }
+	if (Frame.Pressed & (1u << 2)) { Main->LMBDown(); }
+	if (Frame.Released & (1u << 2)) { Main->LMBUp(); }
+}
+
+void UReplaySubsystem::Tick(float DeltaTime)
+{
+	EnsureStarted();
+
+	if (Mode != EMode::Replaying || ReplayIndex == 0)
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	FrameMilliseconds.Add(static_cast<float>((Now - LastFrameTime) * 1000.0));
+	LastFrameTime = Now;
+	FrameHashes.Add(ComputeStateHash());
+
+	if (ReplayIndex >= Frames.Num())
+	{
+		Stop();
+
+		if (FParse::Param(FCommandLine::Get(), TEXT("ExitAfterReplay")))
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+	}
+}
+
+bool UReplaySubsystem::IsTickable() const
+{
+	return !bStarted || Mode == EMode::Replaying;
+}
+
+ETickableTickType UReplaySubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+UWorld* UReplaySubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UReplaySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UReplaySubsystem, STATGROUP_Tickables);
+}
+
+void UReplaySubsystem::Deinitialize()
+{
+	// Leaving the level ends the capture, recordings are saved here
+	Stop();
+
+	Super::Deinitialize();
+}
+
+uint32 UReplaySubsystem::ComputeStateHash() const
+{
+	TArray<float, TInlineAllocator<256>> State;
+
+	if (const AMain* Main = ReplayPawn.Get())
+	{
+		const FVector Location = Main->GetActorLocation();
+		State.Append({ Location.X, Location.Y, Location.Z, Main->GetActorRotation().Yaw, Main->Health, Main->Stamina, static_cast<float>(Main->Coins) });
+	}
+
+	for (TActorIterator<AEnemy> It(GetWorld()); It; ++It)
+	{
+		const FVector Location = It->GetActorLocation();
+		State.Append({ Location.X, Location.Y, Location.Z, It->Health });
+	}
+
+	uint32 Hash = FCrc::MemCrc32(State.GetData(), State.Num() * sizeof(float));
+	for (const FRandomStream& Stream : Streams)
+	{
+		Hash = HashCombine(Hash, static_cast<uint32>(Stream.GetCurrentSeed()));
+	}
+	return Hash;
+}
+
+void UReplaySubsystem::WriteReplayReport() const
+{
+	const FString Path = GetCapturePath(CaptureName, TEXT("replay.csv"));
+
+	// Compare against the previous run of the same capture before overwriting it
+	TArray<FString> PreviousLines;
+	if (FFileHelper::LoadFileToStringArray(PreviousLines, *Path) && PreviousLines.Num() > 1)
+	{
+		int32 FirstMismatch = INDEX_NONE;
+		double PreviousTotalMs = 0.0;
+		for (int32 Line = 1; Line < PreviousLines.Num(); ++Line)
+		{
+			TArray<FString> Columns;
+			PreviousLines[Line].ParseIntoArray(Columns, TEXT(","));
+			if (Columns.Num() < 3)
+			{
+				continue;
+			}
+
+			const int32 Frame = FCString::Atoi(*Columns[0]);
+			const uint32 PreviousHash = static_cast<uint32>(FCString::Strtoui64(*Columns[1], nullptr, 16));
+			if (FirstMismatch == INDEX_NONE && (!FrameHashes.IsValidIndex(Frame) || FrameHashes[Frame] != PreviousHash))
+			{
+				FirstMismatch = Frame;
+			}
+			PreviousTotalMs += FCString::Atod(*Columns[2]);
+		}
+
+		double TotalMs = 0.0;
+		for (float Milliseconds : FrameMilliseconds)
+		{
+			TotalMs += Milliseconds;
+		}
+
+		const int32 PreviousFrames = PreviousLines.Num() - 1;
+		if (FirstMismatch == INDEX_NONE && PreviousFrames == FrameHashes.Num())
+		{
+			UE_LOG(LogFirstProject, Log, TEXT("Replay '%s' matches the previous run, average frame %.3f ms (previous %.3f ms)"),
+				*CaptureName, TotalMs / FMath::Max(FrameMilliseconds.Num(), 1), PreviousTotalMs / PreviousFrames);
+		}
+		else
+		{
+			UE_LOG(LogFirstProject, Warning, TEXT("Replay '%s' diverged from the previous run at frame %d, frame times are not comparable"),
+				*CaptureName, FirstMismatch == INDEX_NONE ? FMath::Min(PreviousFrames, FrameHashes.Num()) : FirstMismatch);
+		}
+	}
+
+	FString Report = TEXT("Frame,StateHash,FrameMs\n");
+	for (int32 Frame = 0; Frame < FrameHashes.Num(); ++Frame)
+	{
+		Report += FString::Printf(TEXT("%d,%08x,%.3f\n"), Frame, FrameHashes[Frame], FrameMilliseconds[Frame]);
+	}
+	FFileHelper::SaveStringToFile(Report, *Path);
+}
+
+FString UReplaySubsystem::GetCapturePath(const FString& Name, const TCHAR* Extension)
+{
+	return FPaths::ProjectSavedDir() / TEXT("InputCaptures") / FString::Printf(TEXT("%s.%s"), *Name, Extension);
+}
+
+#if FIRSTPROJECT_DEBUG_TOOLS
+
+static void OpenCurrentLevelWithOption(UWorld* World, const TCHAR* Option, const TArray<FString>& Args)
+{
+	if (World && Args.Num() > 0)
+	{
+		UGameplayStatics::OpenLevel(World, FName(*UGameplayStatics::GetCurrentLevelName(World)), true, FString::Printf(TEXT("%s=%s"), Option, *Args[0]));
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs RecordInputCommand(
+	TEXT("FirstProject.RecordInput"),
+	TEXT("Reload the level and record the player's input. Usage: FirstProject.RecordInput <Name>, end with FirstProject.StopInputCapture"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		OpenCurrentLevelWithOption(World, TEXT("RecordInput"), Args);
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs ReplayInputCommand(
+	TEXT("FirstProject.ReplayInput"),
+	TEXT("Reload the level and play back a recorded capture with its recorded frame times. Usage: FirstProject.ReplayInput <Name>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		OpenCurrentLevelWithOption(World, TEXT("ReplayInput"), Args);
+	}));
+
+static FAutoConsoleCommandWithWorld StopInputCaptureCommand(
+	TEXT("FirstProject.StopInputCapture"),
+	TEXT("Save the recording in progress, or end a replay early"),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		UReplaySubsystem* Replay = World ? World->GetSubsystem<UReplaySubsystem>() : nullptr;
+		if (Replay)
+		{
+			Replay->Stop();
+		}
+	}));
+
+#endif
@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "InputCoreTypes.h"
+#include "ReplaySubsystem.generated.h"
+
+/** Independent kinds of gameplay randomness, each drawn from its own seeded stream */
+enum class EGameplayRandom : uint8
+{
+	Combat,
+	AI,
+	Spawning,
+
+	Count
+};
+
+/** Player input sampled on one frame of a capture */
+struct FInputCaptureFrame
+{
+	/** One value per AMain input axis, in UReplaySubsystem::AxisNames order */
+	TArray<float> Axes;
+
+	/** Bit per action in UReplaySubsystem::ActionNames order */
+	uint32 Pressed;
+	uint32 Released;
+
+	/** Engine delta time of the recorded frame, replays step by exactly this */
+	double DeltaTime;
+
+	FInputCaptureFrame()
+		: Pressed(0)
+		, Released(0)
+		, DeltaTime(0.0)
+	{
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FInputCaptureFrame& Frame)
+	{
+		return Ar << Frame.Axes << Frame.Pressed << Frame.Released << Frame.DeltaTime;
+	}
+};
+
+/**
+ * Records the player's input and frame time frame by frame, running in real time, and plays it back
+ * stepping the engine by the recorded frame times.
+ * All gameplay randomness goes through the seeded streams here, so a replay of the same capture
+ * runs the same simulation and the per frame state hashes of two runs can be compared directly.
+ *
+ * Start a capture by opening a map with ?RecordInput=<Name> or ?ReplayInput=<Name>,
+ * or with the FirstProject.RecordInput / FirstProject.ReplayInput console commands.
+ * Add -nullrhi for a headless replay and -ExitAfterReplay to quit when it ends.
+ */
+UCLASS()
+class FIRSTPROJECT_API UReplaySubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UReplaySubsystem();
+
+	/** Seeded stream for one kind of gameplay randomness */
+	FRandomStream& GetRandomStream(EGameplayRandom Stream);
+
+	/** Stream of the world WorldContextObject is in, or a shared fallback outside of a world */
+	static FRandomStream& GetWorldRandom(const UObject* WorldContextObject, EGameplayRandom Stream);
+
+	void StartRecording(const FString& CaptureName);
+
+	void StartReplay(const FString& CaptureName);
+
+	/** Save a recording, or finish a replay and write its report */
+	void Stop();
+
+	FORCEINLINE bool IsRecording() const { return Mode == EMode::Recording; }
+	FORCEINLINE bool IsReplaying() const { return Mode == EMode::Replaying; }
+
+	/** Called by AMain at the start of its tick to sample or play back this frame's input */
+	void ProcessPlayerInput(class AMain* Main);
+
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+
+	static const FName AxisNames[];
+	static const FName ActionNames[];
+
+private:
+
+	enum class EMode : uint8
+	{
+		None,
+		Recording,
+		Replaying
+	};
+
+	/** Pick a seed and start any capture requested in the map URL, once per world */
+	void EnsureStarted();
+
+	void Reseed(int32 NewSeed);
+
+	/** Step the engine by the recorded frame times instead of the wall clock while replaying */
+	void SetFixedTimestep(bool bEnable);
+
+	void RecordFrame(AMain* Main);
+
+	void ReplayFrame(AMain* Main);
+
+	uint32 ComputeStateHash() const;
+
+	void WriteReplayReport() const;
+
+	static FString GetCapturePath(const FString& Name, const TCHAR* Extension);
+
+	EMode Mode;
+
+	bool bStarted;
+
+	FString CaptureName;
+
+	int32 Seed;
+
+	FRandomStream Streams[(int32)EGameplayRandom::Count];
+
+	TArray<FInputCaptureFrame> Frames;
+
+	/** Next frame to play back */
+	int32 ReplayIndex;
+
+	/** Keys bound to each action while recording */
+	TArray<TArray<FKey>> ActionKeys;
+
+	TWeakObjectPtr<AMain> ReplayPawn;
+
+	/** State hash and wall clock frame time of every replayed frame */
+	TArray<uint32> FrameHashes;
+	TArray<float> FrameMilliseconds;
+
+	double LastFrameTime;
+
+	bool bPreviousUseFixedTimeStep;
+	double PreviousFixedDeltaTime;
+};
@@ -0,0 +1,547 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SoakTestSubsystem.h"
+#include "FirstProject.h"
+#include "Main.h"
+#include "MainPlayerController.h"
+#include "Enemy.h"
+#include "Pickup.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectIterator.h"
+
+static TAutoConsoleVariable<float> CVarSoakSampleInterval(TEXT("FirstProject.Soak.SampleInterval"), 60.f, TEXT("Seconds between soak samples"));
+static TAutoConsoleVariable<int32> CVarSoakWarmupSamples(TEXT("FirstProject.Soak.WarmupSamples"), 5, TEXT("Samples left out of the growth check while caches fill up"));
+static TAutoConsoleVariable<int32> CVarSoakMinSamples(TEXT("FirstProject.Soak.MinSamples"), 10, TEXT("Samples after the warmup needed before growth is checked"));
+static TAutoConsoleVariable<float> CVarSoakMaxObjectsPerHour(TEXT("FirstProject.Soak.MaxObjectsPerHour"), 200.f, TEXT("Allowed growth of the UObject count of any one class, per hour"));
+static TAutoConsoleVariable<float> CVarSoakMaxActorsPerHour(TEXT("FirstProject.Soak.MaxActorsPerHour"), 20.f, TEXT("Allowed growth of the count of all actors, per hour"));
+// Kept well below the 12 loads an hour the bot does by default, so one actor leaked per load (like the AItemStorage
+// every AMain::LoadGame spawns) fails the soak
+static TAutoConsoleVariable<float> CVarSoakMaxClassActorsPerHour(TEXT("FirstProject.Soak.MaxClassActorsPerHour"), 4.f, TEXT("Allowed growth of the actor count of any one class, per hour"));
+static TAutoConsoleVariable<float> CVarSoakMaxMemoryPerHour(TEXT("FirstProject.Soak.MaxMemoryMBPerHour"), 64.f, TEXT("Allowed growth of resident memory in MB per hour"));
+static TAutoConsoleVariable<float> CVarSoakSaveInterval(TEXT("FirstProject.Soak.SaveInterval"), 90.f, TEXT("Seconds between bot saves"));
+static TAutoConsoleVariable<float> CVarSoakLoadInterval(TEXT("FirstProject.Soak.LoadInterval"), 300.f, TEXT("Seconds between bot loads"));
+
+namespace SoakBot
+{
+	/** Goals farther than this are ignored */
+	const float SearchRadius = 4000.f;
+
+	const float AttackRange = 200.f;
+
+	/** Sprint toward goals farther than this */
+	const float SprintDistance = 1500.f;
+
+	const float WanderRadius = 1500.f;
+
+	/** Seconds without covering StuckDistance before the bot jumps and picks somewhere else */
+	const float StuckSeconds = 3.f;
+	const float StuckDistance = 100.f;
+
+	/** Seconds to lie dead before reloading */
+	const float RespawnDelay = 3.f;
+}
+
+USoakTestSubsystem::USoakTestSubsystem()
+{
+	bRunning = false;
+	bExitWhenDone = false;
+	StartSeconds = 0.0;
+	EndSeconds = 0.0;
+	NextSampleSeconds = 0.0;
+	NextSaveSeconds = 0.0;
+	NextLoadSeconds = 0.0;
+	bSamplePending = false;
+	WanderTarget = FVector::ZeroVector;
+	SecondsUntilGoalUpdate = 0.f;
+	LastBotLocation = FVector::ZeroVector;
+	SecondsSinceProgress = 0.f;
+	SecondsDead = 0.f;
+	bBotAttackHeld = false;
+}
+
+bool USoakTestSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+#if UE_BUILD_SHIPPING
+	return false;
+#else
+	return Super::ShouldCreateSubsystem(Outer);
+#endif
+}
+
+void USoakTestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("SoakTest")))
+	{
+		float Minutes = 240.f;
+		FParse::Value(FCommandLine::Get(), TEXT("SoakMinutes="), Minutes);
+
+		bExitWhenDone = true;
+		StartSoak(Minutes);
+	}
+}
+
+void USoakTestSubsystem::Deinitialize()
+{
+	if (bRunning)
+	{
+		bExitWhenDone = false;
+		StopSoak();
+	}
+
+	Super::Deinitialize();
+}
+
+void USoakTestSubsystem::StartSoak(float Minutes)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	bRunning = true;
+	StartSeconds = Now;
+	EndSeconds = Now + Minutes * 60.0;
+	NextSampleSeconds = Now;
+	// Save straight away so the first load and the first death have something to restore
+	NextSaveSeconds = Now;
+	NextLoadSeconds = Now + CVarSoakLoadInterval.GetValueOnGameThread();
+	bSamplePending = false;
+
+	Series.Reset();
+	SampleTimes.Reset();
+
+	BotGoal = nullptr;
+	SecondsUntilGoalUpdate = 0.f;
+	SecondsSinceProgress = 0.f;
+	SecondsDead = 0.f;
+	bBotAttackHeld = false;
+	BotRandom.Initialize(static_cast<int32>(FPlatformTime::Cycles()));
+
+	UE_LOG(LogFirstProject, Log, TEXT("Soak test started for %.0f minutes"), Minutes);
+
+	const float LoadsPerHour = 3600.f / FMath::Max(CVarSoakLoadInterval.GetValueOnGameThread(), 1.f);
+	if (LoadsPerHour <= CVarSoakMaxClassActorsPerHour.GetValueOnGameThread())
+	{
+		UE_LOG(LogFirstProject, Warning, TEXT("Soak test loads %.1f times per hour, an actor leaked per load stays under FirstProject.Soak.MaxClassActorsPerHour"), LoadsPerHour);
+	}
+}
+
+void USoakTestSubsystem::StopSoak()
+{
+	if (!bRunning)
+	{
+		return;
+	}
+	bRunning = false;
+
+	UWorld* World = GetGameInstance()->GetWorld();
+	APlayerController* PlayerController = World ? GetGameInstance()->GetFirstLocalPlayerController(World) : nullptr;
+	AMain* Main = PlayerController ? Cast<AMain>(PlayerController->GetPawn()) : nullptr;
+	if (Main)
+	{
+		Main->ShiftKeyUp();
+		Main->LMBUp();
+	}
+
+	const TArray<FString> Failures = FindGrowingSeries();
+	for (const FString& Failure : Failures)
+	{
+		UE_LOG(LogFirstProject, Error, TEXT("Soak test: %s"), *Failure);
+	}
+	UE_LOG(LogFirstProject, Log, TEXT("Soak test %s after %.1f minutes and %d samples"),
+		Failures.Num() > 0 ? TEXT("failed") : TEXT("passed"), (FPlatformTime::Seconds() - StartSeconds) / 60.0, SampleTimes.Num());
+
+	WriteReport(Failures);
+
+	if (bExitWhenDone)
+	{
+		// Lets the script that started the soak tell a failure from a pass
+		FPlatformMisc::RequestExitWithStatus(false, Failures.Num() > 0 ? 1 : 0);
+	}
+}
+
+void USoakTestSubsystem::Tick(float DeltaTime)
+{
+	UWorld* World = GetGameInstance()->GetWorld();
+	APlayerController* PlayerController = World ? GetGameInstance()->GetFirstLocalPlayerController(World) : nullptr;
+	AMain* Main = PlayerController ? Cast<AMain>(PlayerController->GetPawn()) : nullptr;
+	if (Main)
+	{
+		UpdateBot(Main, DeltaTime);
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	if (bSamplePending)
+	{
+		bSamplePending = false;
+		TakeSample();
+		if (FindGrowingSeries().Num() > 0)
+		{
+			StopSoak();
+			return;
+		}
+	}
+	else if (Now >= NextSampleSeconds)
+	{
+		// Sample on the next frame, once the collection has run
+		NextSampleSeconds = Now + CVarSoakSampleInterval.GetValueOnGameThread();
+		GEngine->ForceGarbageCollection(true);
+		bSamplePending = true;
+	}
+
+	if (Now >= EndSeconds)
+	{
+		StopSoak();
+	}
+}
+
+bool USoakTestSubsystem::IsTickable() const
+{
+	return bRunning;
+}
+
+bool USoakTestSubsystem::IsTickableWhenPaused() const
+{
+	// The bot closes the pause menu if anything opens it
+	return true;
+}
+
+ETickableTickType USoakTestSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+TStatId USoakTestSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USoakTestSubsystem, STATGROUP_Tickables);
+}
+
+void USoakTestSubsystem::UpdateBot(AMain* Main, float DeltaTime)
+{
+	APlayerController* PlayerController = Cast<APlayerController>(Main->GetController());
+	if (!PlayerController)
+	{
+		return;
+	}
+
+	if (Main->MainPlayerController && Main->MainPlayerController->bPauseMenuVisible)
+	{
+		Main->MainPlayerController->RemovePauseMenu();
+	}
+
+	if (Main->MovementStatus == EMovementStatus::EMS_Dead)
+	{
+		SecondsDead += DeltaTime;
+		if (SecondsDead >= SoakBot::RespawnDelay)
+		{
+			SecondsDead = 0.f;
+			Main->LoadGame(true);
+		}
+		return;
+	}
+	SecondsDead = 0.f;
+
+	const double Now = FPlatformTime::Seconds();
+	if (Now >= NextSaveSeconds)
+	{
+		NextSaveSeconds = Now + CVarSoakSaveInterval.GetValueOnGameThread();
+		Main->SaveGame();
+	}
+	if (Now >= NextLoadSeconds)
+	{
+		NextLoadSeconds = Now + CVarSoakLoadInterval.GetValueOnGameThread();
+		Main->LoadGame(true);
+		return;
+	}
+
+	if (bBotAttackHeld)
+	{
+		Main->LMBUp();
+		bBotAttackHeld = false;
+	}
+
+	const FVector Location = Main->GetActorLocation();
+	SecondsSinceProgress += DeltaTime;
+	if (FVector::DistSquared2D(Location, LastBotLocation) >= FMath::Square(SoakBot::StuckDistance))
+	{
+		LastBotLocation = Location;
+		SecondsSinceProgress = 0.f;
+	}
+	else if (SecondsSinceProgress >= SoakBot::StuckSeconds)
+	{
+		// Wander somewhere else for a while before trying the goal again
+		SecondsSinceProgress = 0.f;
+		BotGoal = nullptr;
+		WanderTarget = Location + BotRandom.GetUnitVector().GetSafeNormal2D() * SoakBot::WanderRadius;
+		SecondsUntilGoalUpdate = SoakBot::StuckSeconds;
+		Main->Jump();
+	}
+
+	SecondsUntilGoalUpdate -= DeltaTime;
+	if (SecondsUntilGoalUpdate <= 0.f)
+	{
+		SecondsUntilGoalUpdate = 1.f;
+		Main->StopJumping();
+		BotGoal = FindBotGoal(Main);
+	}
+
+	// Weapons on the floor are picked up with the attack button
+	if (Main->ActiveOverlappingItem)
+	{
+		Main->LMBDown();
+		bBotAttackHeld = true;
+		return;
+	}
+
+	AEnemy* Enemy = Cast<AEnemy>(BotGoal.Get());
+	if (Enemy && !Enemy->Alive())
+	{
+		BotGoal = nullptr;
+		Enemy = nullptr;
+	}
+
+	FVector ToTarget = (BotGoal.IsValid() ? BotGoal->GetActorLocation() : WanderTarget) - Location;
+	ToTarget.Z = 0.f;
+	const float Distance = ToTarget.Size();
+
+	if (!BotGoal.IsValid() && Distance < SoakBot::StuckDistance)
+	{
+		WanderTarget = Location + BotRandom.GetUnitVector().GetSafeNormal2D() * SoakBot::WanderRadius;
+		return;
+	}
+
+	PlayerController->SetControlRotation(FRotator(0.f, ToTarget.Rotation().Yaw, 0.f));
+
+	if (Enemy && Distance <= SoakBot::AttackRange)
+	{
+		// Standing still to fight isn't being stuck
+		SecondsSinceProgress = 0.f;
+		Main->ShiftKeyUp();
+		Main->LMBDown();
+		bBotAttackHeld = true;
+		return;
+	}
+
+	if (Distance > SoakBot::SprintDistance)
+	{
+		Main->ShiftKeyDown();
+	}
+	else
+	{
+		Main->ShiftKeyUp();
+	}
+	Main->MoveForwrd(1.f);
+}
+
+AActor* USoakTestSubsystem::FindBotGoal(AMain* Main) const
+{
+	UWorld* World = Main->GetWorld();
+	const FVector Location = Main->GetActorLocation();
+
+	AActor* Goal = nullptr;
+	float GoalDistanceSq = FMath::Square(SoakBot::SearchRadius);
+	for (TActorIterator<AEnemy> It(World); It; ++It)
+	{
+		const float DistanceSq = FVector::DistSquared(Location, It->GetActorLocation());
+		if (It->Alive() && DistanceSq < GoalDistanceSq)
+		{
+			Goal = *It;
+			GoalDistanceSq = DistanceSq;
+		}
+	}
+	if (Goal)
+	{
+		return Goal;
+	}
+
+	for (TActorIterator<APickup> It(World); It; ++It)
+	{
+		const float DistanceSq = FVector::DistSquared(Location, It->GetActorLocation());
+		if (DistanceSq < GoalDistanceSq)
+		{
+			Goal = *It;
+			GoalDistanceSq = DistanceSq;
+		}
+	}
+	return Goal;
+}
+
+void USoakTestSubsystem::TakeSample()
+{
+	SampleTimes.Add(static_cast<float>(FPlatformTime::Seconds() - StartSeconds));
+
+	TMap<UClass*, int32> ObjectCounts;
+	for (FObjectIterator It; It; ++It)
+	{
+		++ObjectCounts.FindOrAdd(It->GetClass());
+	}
+
+	const float MaxObjectsPerHour = CVarSoakMaxObjectsPerHour.GetValueOnGameThread();
+	for (const TPair<UClass*, int32>& Count : ObjectCounts)
+	{
+		AddSample(TEXT("Objects.") + Count.Key->GetName(), Count.Value, MaxObjectsPerHour);
+	}
+
+	TMap<UClass*, int32> ActorCounts;
+	int32 NumActors = 0;
+	UWorld* World = GetGameInstance()->GetWorld();
+	if (World)
+	{
+		for (TActorIterator<AActor> It(World); It; ++It)
+		{
+			++ActorCounts.FindOrAdd(It->GetClass());
+			++NumActors;
+		}
+	}
+
+	const float MaxClassActorsPerHour = CVarSoakMaxClassActorsPerHour.GetValueOnGameThread();
+	for (const TPair<UClass*, int32>& Count : ActorCounts)
+	{
+		AddSample(TEXT("Actors.") + Count.Key->GetName(), Count.Value, MaxClassActorsPerHour);
+	}
+	AddSample(TEXT("Actors.Total"), NumActors, CVarSoakMaxActorsPerHour.GetValueOnGameThread());
+
+	AddSample(TEXT("Memory.UsedPhysicalMB"), FPlatformMemory::GetStats().UsedPhysical / (1024.f * 1024.f), CVarSoakMaxMemoryPerHour.GetValueOnGameThread());
+
+	// Classes that disappeared since the last sample count as zero
+	for (TPair<FString, FSoakSeries>& Pair : Series)
+	{
+		Pair.Value.Values.SetNumZeroed(SampleTimes.Num());
+	}
+}
+
+void USoakTestSubsystem::AddSample(const FString& Name, float Value, float MaxSlopePerHour)
+{
+	FSoakSeries* Samples = Series.Find(Name);
+	if (!Samples)
+	{
+		// Zero for the samples before the class first showed up
+		Samples = &Series.Add(Name);
+		Samples->FirstSample = SampleTimes.Num() - 1;
+		Samples->Values.SetNumZeroed(Samples->FirstSample);
+	}
+	Samples->Values.Add(Value);
+	Samples->MaxSlopePerHour = MaxSlopePerHour;
+}
+
+float USoakTestSubsystem::GetSlopePerHour(const FSoakSeries& Samples) const
+{
+	// A class that first shows up mid run would otherwise look like growth from zero
+	const int32 First = FMath::Max(CVarSoakWarmupSamples.GetValueOnGameThread(), Samples.FirstSample);
+	const int32 Count = Samples.Values.Num() - First;
+	if (Count < FMath::Max(CVarSoakMinSamples.GetValueOnGameThread(), 2))
+	{
+		return 0.f;
+	}
+
+	double MeanHours = 0.0;
+	double MeanValue = 0.0;
+	for (int32 Index = First; Index < Samples.Values.Num(); ++Index)
+	{
+		MeanHours += SampleTimes[Index] / 3600.0;
+		MeanValue += Samples.Values[Index];
+	}
+	MeanHours /= Count;
+	MeanValue /= Count;
+
+	double Covariance = 0.0;
+	double Variance = 0.0;
+	for (int32 Index = First; Index < Samples.Values.Num(); ++Index)
+	{
+		const double Hours = SampleTimes[Index] / 3600.0 - MeanHours;
+		Covariance += Hours * (Samples.Values[Index] - MeanValue);
+		Variance += Hours * Hours;
+	}
+	return Variance > 0.0 ? static_cast<float>(Covariance / Variance) : 0.f;
+}
+
+TArray<FString> USoakTestSubsystem::FindGrowingSeries() const
+{
+	TArray<FString> Failures;
+	for (const TPair<FString, FSoakSeries>& Pair : Series)
+	{
+		const float Slope = GetSlopePerHour(Pair.Value);
+		if (Slope > Pair.Value.MaxSlopePerHour)
+		{
+			Failures.Add(FString::Printf(TEXT("%s grows %.1f per hour, limit %.1f (%.0f -> %.0f)"),
+				*Pair.Key, Slope, Pair.Value.MaxSlopePerHour, Pair.Value.Values[Pair.Value.FirstSample], Pair.Value.Values.Last()));
+		}
+	}
+	return Failures;
+}
+
+void USoakTestSubsystem::WriteReport(const TArray<FString>& Failures) const
+{
+	TArray<FString> Names;
+	Series.GetKeys(Names);
+	Names.Sort();
+
+	const FString Prefix = FPaths::ProjectSavedDir() / TEXT("Soak") / FString::Printf(TEXT("Soak-%s"), *FDateTime::Now().ToString());
+
+	// One row per sample, one column per series
+	FString Samples = TEXT("Seconds");
+	for (const FString& Name : Names)
+	{
+		Samples += TEXT(",") + Name;
+	}
+	Samples += TEXT("\n");
+	for (int32 Sample = 0; Sample < SampleTimes.Num(); ++Sample)
+	{
+		Samples += FString::Printf(TEXT("%.0f"), SampleTimes[Sample]);
+		for (const FString& Name : Names)
+		{
+			Samples += FString::Printf(TEXT(",%g"), Series[Name].Values[Sample]);
+		}
+		Samples += TEXT("\n");
+	}
+	FFileHelper::SaveStringToFile(Samples, *(Prefix + TEXT(".csv")));
+
+	FString Summary = TEXT("Series,First,Last,SlopePerHour,MaxSlopePerHour\n");
+	for (const FString& Name : Names)
+	{
+		const FSoakSeries& Values = Series[Name];
+		Summary += FString::Printf(TEXT("%s,%g,%g,%.2f,%.2f\n"), *Name, Values.Values.IsValidIndex(Values.FirstSample) ? Values.Values[Values.FirstSample] : 0.f,
+			Values.Values.Num() > 0 ? Values.Values.Last() : 0.f, GetSlopePerHour(Values), Values.MaxSlopePerHour);
+	}
+	for (const FString& Failure : Failures)
+	{
+		Summary += TEXT("# FAILED ") + Failure + TEXT("\n");
+	}
+	FFileHelper::SaveStringToFile(Summary, *(Prefix + TEXT("-summary.csv")));
+}
+
+#if FIRSTPROJECT_DEBUG_TOOLS
+
+static FAutoConsoleCommandWithWorldAndArgs StartSoakCommand(
+	TEXT("FirstProject.StartSoak"),
+	TEXT("Let a bot play and watch object, actor and memory counts for leaks. Usage: FirstProject.StartSoak [Minutes=60]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		USoakTestSubsystem* Soak = World && World->GetGameInstance() ? World->GetGameInstance()->GetSubsystem<USoakTestSubsystem>() : nullptr;
+		if (Soak)
+		{
+			Soak->StartSoak(Args.Num() > 0 ? FCString::Atof(*Args[0]) : 60.f);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld StopSoakCommand(
+	TEXT("FirstProject.StopSoak"),
+	TEXT("End the soak test and write its report"),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		USoakTestSubsystem* Soak = World && World->GetGameInstance() ? World->GetGameInstance()->GetSubsystem<USoakTestSubsystem>() : nullptr;
+		if (Soak)
+		{
+			Soak->StopSoak();
+		}
+	}));
+
+#endif
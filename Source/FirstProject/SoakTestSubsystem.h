@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
+#include "SoakTestSubsystem.generated.h"
+
+/** Values of one sampled quantity, one per sample */
+struct FSoakSeries
+{
+	TArray<float> Values;
+
+	/** Sample the series first showed up in, the zeros before it aren't part of the growth check */
+	int32 FirstSample;
+
+	/** Growth per hour above which the soak fails */
+	float MaxSlopePerHour;
+
+	FSoakSeries()
+		: FirstSample(0)
+		, MaxSlopePerHour(0.f)
+	{
+	}
+};
+
+/**
+ * Long running leak hunt. A bot drives the player around, fighting, collecting, saving and loading,
+ * while UObject counts per class, actor counts per class and resident memory are sampled at intervals.
+ * The soak fails as soon as any series grows faster than its FirstProject.Soak.* slope limit.
+ *
+ * Lives on the game instance so it keeps going across the level loads the bot triggers.
+ * Start headless with: FirstProject SunTemple -game -nullrhi -SoakTest [-SoakMinutes=240],
+ * it quits when done, with exit code 1 when something grew too fast. Reports go to Saved/Soak.
+ * Not created in Shipping builds.
+ */
+UCLASS()
+class FIRSTPROJECT_API USoakTestSubsystem : public UGameInstanceSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	USoakTestSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Start driving the player and sampling, for Minutes of real time */
+	void StartSoak(float Minutes);
+
+	/** Check the series one last time and write the report */
+	void StopSoak();
+
+	FORCEINLINE bool IsRunning() const { return bRunning; }
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual bool IsTickableWhenPaused() const override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	void UpdateBot(class AMain* Main, float DeltaTime);
+
+	/** Nearest live enemy, then nearest pickup, or null to wander */
+	AActor* FindBotGoal(AMain* Main) const;
+
+	void TakeSample();
+
+	void AddSample(const FString& Name, float Value, float MaxSlopePerHour);
+
+	/** Least squares slope of the samples after the warmup and after the series showed up, per hour */
+	float GetSlopePerHour(const FSoakSeries& Samples) const;
+
+	/** Series over their limit, empty when there aren't enough samples to tell */
+	TArray<FString> FindGrowingSeries() const;
+
+	void WriteReport(const TArray<FString>& Failures) const;
+
+	bool bRunning;
+
+	/** Quit when the soak ends, set when started from the command line */
+	bool bExitWhenDone;
+
+	double StartSeconds;
+	double EndSeconds;
+	double NextSampleSeconds;
+	double NextSaveSeconds;
+	double NextLoadSeconds;
+
+	/** Garbage collection was requested so the next sample doesn't count unreachable objects */
+	bool bSamplePending;
+
+	TMap<FString, FSoakSeries> Series;
+
+	/** Seconds since start of every sample */
+	TArray<float> SampleTimes;
+
+	TWeakObjectPtr<AActor> BotGoal;
+	FVector WanderTarget;
+	float SecondsUntilGoalUpdate;
+
+	FVector LastBotLocation;
+	float SecondsSinceProgress;
+
+	float SecondsDead;
+
+	/** The bot attacks by tapping, so the button is released the frame after it is pressed */
+	bool bBotAttackHeld;
+
+	FRandomStream BotRandom;
+};
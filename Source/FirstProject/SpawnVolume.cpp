@@ -2,10 +2,15 @@
 
 
 #include "SpawnVolume.h"
+#include "FirstProject.h"
 #include "Components/BoxComponent.h"
-#include "Kismet/KismetMathLibrary.h"
 #include "Enemy.h"
 #include "AIController.h"
+#include "Kismet/GameplayStatics.h"
+#include "TimerManager.h"
+#include "ReplaySubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spawn Volume Spawn"), STAT_SpawnVolumeSpawn, STATGROUP_FirstProject);
 
 
 // Sets default values
@@ -13,17 +18,20 @@ ASpawnVolume::ASpawnVolume()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
+	// Only tick while the player is close enough to activate the volume
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	SpawningBox = CreateDefaultSubobject<UBoxComponent>(TEXT("SpawningBox"));
 	 
-	
+	ActivationRadius = 3000.f;
+	DespawnRadius = 5000.f;
+	ProximityCheckInterval = 0.5f;
+	bActive = false;
 }
 
 // Called when the game starts or when spawned
 void ASpawnVolume::BeginPlay()
 {
-	Super::BeginPlay();
-
 	if (Actor_1 && Actor_2 && Actor_3 && Actor_4)
 	{
 		SpawnArray.Add(Actor_1);
@@ -31,7 +39,15 @@ void ASpawnVolume::BeginPlay()
 		SpawnArray.Add(Actor_3);
 		SpawnArray.Add(Actor_4);
 	}
-	
+
+	// Decide the initial state before Blueprint BeginPlay gets a chance to spawn
+	UpdateProximity();
+
+	Super::BeginPlay();
+
+	// Stagger the first check so volumes placed together don't all test on the same frame
+	GetWorldTimerManager().SetTimer(ProximityTimer, this, &ASpawnVolume::UpdateProximity, ProximityCheckInterval,
+		true, UReplaySubsystem::GetWorldRandom(this, EGameplayRandom::Spawning).FRandRange(0.f, ProximityCheckInterval));
 }
 
 // Called every frame
@@ -46,14 +62,15 @@ FVector ASpawnVolume::GetSpawnPoint()
 	FVector Extent = SpawningBox->GetScaledBoxExtent();
 	FVector Origin = SpawningBox->GetComponentLocation();
 
-	return UKismetMathLibrary::RandomPointInBoundingBox(Origin, Extent);
+	FRandomStream& Random = UReplaySubsystem::GetWorldRandom(this, EGameplayRandom::Spawning);
+	return Origin + FVector(Random.FRandRange(-Extent.X, Extent.X), Random.FRandRange(-Extent.Y, Extent.Y), Random.FRandRange(-Extent.Z, Extent.Z));
 }
 
 TSubclassOf<AActor> ASpawnVolume::GetSpawnActor()
 {
 	if (SpawnArray.Num() > 0)
 	{
-		int32 Selection = FMath::RandRange(0, SpawnArray.Num() - 1);
+		int32 Selection = UReplaySubsystem::GetWorldRandom(this, EGameplayRandom::Spawning).RandRange(0, SpawnArray.Num() - 1);
 
 		return SpawnArray[Selection];
 	}
@@ -62,31 +79,143 @@ TSubclassOf<AActor> ASpawnVolume::GetSpawnActor()
 
 void ASpawnVolume::SpawnOurActor_Implementation(UClass* ToSpawn, const FVector& Location)
 {
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_SpawnVolumeSpawn);
+
 	if (ToSpawn)
 	{
-		UWorld* World = GetWorld();
-		FActorSpawnParameters SpawnParams;
+		FSpawnRecord Record;
+		Record.ActorClass = ToSpawn;
+		Record.Transform = FTransform(FRotator(0.f), Location);
 
-		if (World)
+		if (!bActive)
 		{
+			// Nobody is around to see it, keep it as a record until the player shows up
+			DormantRecords.Add(Record);
+			return;
+		}
+
+		SpawnFromRecord(Record);
+	}
+}
+
+void ASpawnVolume::UpdateProximity()
+{
+	APawn* Player = UGameplayStatics::GetPlayerPawn(this, 0);
+	if (!Player)
+	{
+		return;
+	}
 
-			AActor* Actor =	World->SpawnActor<AActor>(ToSpawn, Location, FRotator(0.f), SpawnParams);
-			AEnemy* Enemy = Cast<AEnemy>(Actor);
+	const FVector PlayerLocation = Player->GetActorLocation();
+	const float ActivationRadiusSq = FMath::Square(ActivationRadius);
+	const float DespawnRadiusSq = FMath::Square(DespawnRadius);
 
-			if (Enemy)
+	const bool bPlayerInRange = FVector::DistSquared(PlayerLocation, GetActorLocation()) <= ActivationRadiusSq;
+	if (bPlayerInRange != bActive)
+	{
+		SetVolumeActive(bPlayerInRange);
+	}
+
+	for (int32 Index = SpawnedActors.Num() - 1; Index >= 0; --Index)
+	{
+		AActor* Actor = SpawnedActors[Index].Get();
+		if (!Actor || Actor->IsPendingKill())
+		{
+			SpawnedActors.RemoveAtSwap(Index);
+		}
+		else if (FVector::DistSquared(PlayerLocation, Actor->GetActorLocation()) > DespawnRadiusSq)
+		{
+			SpawnedActors.RemoveAtSwap(Index);
+			DespawnToRecord(Actor);
+		}
+	}
+
+	if (bActive)
+	{
+		// Realize inside the activation radius so actors near the despawn edge don't flicker in and out
+		for (int32 Index = DormantRecords.Num() - 1; Index >= 0; --Index)
+		{
+			if (FVector::DistSquared(PlayerLocation, DormantRecords[Index].Transform.GetLocation()) <= ActivationRadiusSq)
 			{
-				Enemy->SpawnDefaultController();
-
-				AAIController* AICont = Cast<AAIController>(Enemy->GetController());
-				if (AICont)
-				{
-					Enemy->AIController = AICont;
-				}
-				
+				const FSpawnRecord Record = DormantRecords[Index];
+				DormantRecords.RemoveAtSwap(Index);
+				SpawnFromRecord(Record);
 			}
-			
 		}
-		
 	}
 }
 
+void ASpawnVolume::SetVolumeActive(bool bNewActive)
+{
+	bActive = bNewActive;
+	SetActorTickEnabled(bActive);
+
+	if (bActive)
+	{
+		OnVolumeActivated();
+	}
+	else
+	{
+		OnVolumeDeactivated();
+	}
+}
+
+AActor* ASpawnVolume::SpawnFromRecord(const FSpawnRecord& Record)
+{
+	UWorld* World = GetWorld();
+	if (!World || !Record.ActorClass)
+	{
+		return nullptr;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	FIRSTPROJECT_LLM_SCOPE(Record.ActorClass->IsChildOf<AEnemy>() ? EFirstProjectLLMTag::Enemies : EFirstProjectLLMTag::Items);
+	AActor* Actor = World->SpawnActor<AActor>(Record.ActorClass, Record.Transform, SpawnParams);
+	AEnemy* Enemy = Cast<AEnemy>(Actor);
+
+	if (Enemy)
+	{
+		if (Record.Health > 0.f)
+		{
+			Enemy->Health = Record.Health;
+		}
+
+		Enemy->SpawnDefaultController();
+
+		AAIController* AICont = Cast<AAIController>(Enemy->GetController());
+		if (AICont)
+		{
+			Enemy->AIController = AICont;
+		}
+	}
+
+	if (Actor)
+	{
+		SpawnedActors.Add(Actor);
+	}
+	return Actor;
+}
+
+void ASpawnVolume::DespawnToRecord(AActor* Actor)
+{
+	AEnemy* Enemy = Cast<AEnemy>(Actor);
+	if (Enemy && !Enemy->Alive())
+	{
+		// Dead enemies are already on their way out, nothing to bring back
+		return;
+	}
+
+	FSpawnRecord Record;
+	Record.ActorClass = Actor->GetClass();
+	Record.Transform = Actor->GetActorTransform();
+	if (Enemy)
+	{
+		Record.Health = Enemy->Health;
+	}
+	DormantRecords.Add(Record);
+
+	Actor->Destroy();
+}
+
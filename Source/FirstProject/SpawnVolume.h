@@ -6,6 +6,28 @@
 #include "GameFramework/Actor.h"
 #include "SpawnVolume.generated.h"
 
+/** Compact stand-in for an actor the volume despawned while the player was away */
+USTRUCT()
+struct FSpawnRecord
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TSubclassOf<AActor> ActorClass;
+
+	UPROPERTY()
+	FTransform Transform;
+
+	/** Health to restore on realize, negative when the actor has none */
+	UPROPERTY()
+	float Health;
+
+	FSpawnRecord()
+		: Health(-1.f)
+	{
+	}
+};
+
 UCLASS()
 class FIRSTPROJECT_API ASpawnVolume : public AActor
 {
@@ -32,6 +54,30 @@ public:
 
 	TArray<TSubclassOf<AActor>> SpawnArray;
 
+	/** Volume wakes up when the player gets this close to it */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning | Proximity")
+	float ActivationRadius;
+
+	/** Owned actors farther than this from the player are despawned into records */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning | Proximity")
+	float DespawnRadius;
+
+	/** Seconds between player proximity checks */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning | Proximity")
+	float ProximityCheckInterval;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Spawning | Proximity")
+	bool bActive;
+
+	FTimerHandle ProximityTimer;
+
+	/** Live actors spawned by this volume */
+	TArray<TWeakObjectPtr<AActor>> SpawnedActors;
+
+	/** Actors spawned by this volume that are currently despawned */
+	UPROPERTY()
+	TArray<FSpawnRecord> DormantRecords;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
@@ -49,4 +95,21 @@ public:
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Spawning")
 	void SpawnOurActor(UClass* ToSpawn, const FVector& Location);
 
+	/** Check player distance, wake or sleep the volume and stream owned actors in and out */
+	void UpdateProximity();
+
+	void SetVolumeActive(bool bNewActive);
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Spawning")
+	void OnVolumeActivated();
+
+	UFUNCTION(BlueprintImplementableEvent, Category = "Spawning")
+	void OnVolumeDeactivated();
+
+private:
+
+	AActor* SpawnFromRecord(const FSpawnRecord& Record);
+
+	void DespawnToRecord(AActor* Actor);
+
 };
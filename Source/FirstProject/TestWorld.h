@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+/**
+ * Empty transient game world for automation tests, so results don't depend on the map, AI or rendering.
+ * Spawned actors don't BeginPlay unless the test dispatches it.
+ */
+class FFirstProjectTestWorld : public FNoncopyable
+{
+public:
+
+	explicit FFirstProjectTestWorld(const TCHAR* Name)
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false, Name);
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+		World->InitializeActorsForPlay(FURL());
+	}
+
+	~FFirstProjectTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		World->RemoveFromRoot();
+	}
+
+	template <typename ActorType>
+	ActorType* Spawn(const FTransform& Transform = FTransform::Identity, UClass* Class = ActorType::StaticClass())
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		return World->SpawnActor<ActorType>(Class, Transform, SpawnParams);
+	}
+
+	FORCEINLINE UWorld* Get() const { return World; }
+
+private:
+
+	UWorld* World;
+};
+
+#endif
@@ -2,6 +2,8 @@
 
 
 #include "Weapon.h"
+#include "FirstProject.h"
+#include "PerformanceSubsystem.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Main.h"
 #include "Engine/SkeletalMeshSocket.h"
@@ -9,8 +11,11 @@
 #include "Kismet/GameplayStatics.h"
 #include "Particles/ParticleSystemComponent.h"
 #include "Components/BoxComponent.h"
+#include "Components/SphereComponent.h"
 #include "Enemy.h"
 
+DECLARE_CYCLE_STAT(TEXT("Weapon Combat Overlap"), STAT_WeaponCombatOverlap, STATGROUP_FirstProject);
+
 AWeapon::AWeapon()
 {
 	SkeletalMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("SkeletalMesh"));
@@ -69,6 +74,8 @@ void AWeapon::OnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* Oth
 void AWeapon::CombatOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
 	UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+	FIRSTPROJECT_SCOPE_CYCLE_COUNTER(STAT_WeaponCombatOverlap);
+
 	if (OtherActor)
 	{
 		AEnemy* Enemy = Cast<AEnemy>(OtherActor);
@@ -81,8 +88,9 @@ void AWeapon::CombatOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActo
 				{
 					FVector SocketLocation = WeaponSocket->GetSocketLocation(SkeletalMesh);
 					
-					UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), Enemy->HitParticle, SocketLocation,
+					UParticleSystemComponent* Emitter = UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), Enemy->HitParticle, SocketLocation,
 					FRotator(0.f), false);
+					UPerformanceSubsystem::NotifyEmitterSpawned(this, Emitter);
 				}
 			}
 			if(Enemy->HitSound)
@@ -120,7 +128,7 @@ void AWeapon::Equip(AMain* Character)
 		if(RightHandSocket)
 		{
 			RightHandSocket->AttachActor(this, Character->GetMesh());
-			bRotate = false;
+			SetRotation(false, RotationRate);
 
 			Character->SetEquippedWeapon(this);
 			Character->SetActiveOverlappingItem(nullptr);
@@ -129,10 +137,14 @@ void AWeapon::Equip(AMain* Character)
 		{
 			UGameplayStatics::PlaySound2D(this, OnEquipSound);
 		}
-		if (!bWeaponParticles)
+		if (!bWeaponParticles && IdleParticlesComponent)
 		{
-			IdleParticlesComponent->Deactivate();
+			IdleParticlesComponent->DestroyComponent();
+			IdleParticlesComponent = nullptr;
 		}
+
+		// Pickup sphere only matters on the ground, drop its physics body while held
+		CollisionVolume->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 	}
 }
 
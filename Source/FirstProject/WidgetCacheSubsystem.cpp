@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WidgetCacheSubsystem.h"
+#include "Blueprint/UserWidget.h"
+#include "GameFramework/PlayerController.h"
+
+UUserWidget* UWidgetCacheSubsystem::GetWidget(TSubclassOf<UUserWidget> WidgetClass, APlayerController* OwningPlayer)
+{
+	if (!WidgetClass || !OwningPlayer)
+	{
+		return nullptr;
+	}
+
+	UUserWidget*& Widget = Widgets.FindOrAdd(WidgetClass);
+	if (!Widget)
+	{
+		// Outered to the game instance, so it outlives the controller that created it
+		Widget = CreateWidget<UUserWidget>(OwningPlayer, WidgetClass);
+	}
+	else if (Widget->GetOwningPlayer() != OwningPlayer)
+	{
+		Widget->SetOwningPlayer(OwningPlayer);
+	}
+	return Widget;
+}
+
+UUserWidget* UWidgetCacheSubsystem::FindWidget(TSubclassOf<UUserWidget> WidgetClass) const
+{
+	UUserWidget* const* Widget = Widgets.Find(WidgetClass);
+	return Widget ? *Widget : nullptr;
+}
+
+void UWidgetCacheSubsystem::Deinitialize()
+{
+	Widgets.Empty();
+
+	Super::Deinitialize();
+}
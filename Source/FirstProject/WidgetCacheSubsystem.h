@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "WidgetCacheSubsystem.generated.h"
+
+/**
+ * Keeps one instance of each full screen widget for the whole session.
+ * Player controllers are recreated on every level load, the widgets they show are not.
+ */
+UCLASS()
+class FIRSTPROJECT_API UWidgetCacheSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Cached instance of WidgetClass, created on first request and handed over to OwningPlayer */
+	class UUserWidget* GetWidget(TSubclassOf<UUserWidget> WidgetClass, class APlayerController* OwningPlayer);
+
+	/** Cached instance of WidgetClass, or null if it was never requested */
+	UUserWidget* FindWidget(TSubclassOf<UUserWidget> WidgetClass) const;
+
+	virtual void Deinitialize() override;
+
+private:
+
+	UPROPERTY()
+	TMap<UClass*, UUserWidget*> Widgets;
+};
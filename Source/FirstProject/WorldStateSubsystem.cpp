@@ -0,0 +1,196 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WorldStateSubsystem.h"
+#include "FirstProject.h"
+#include "Item.h"
+#include "Pickup.h"
+#include "Explosive.h"
+#include "Enemy.h"
+#include "Engine/GameInstance.h"
+#include "Engine/Level.h"
+
+void UWorldStateSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostWorldInitializationHandle = FWorldDelegates::OnPostWorldInitialization.AddUObject(this, &UWorldStateSubsystem::OnPostWorldInitialization);
+}
+
+void UWorldStateSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnPostWorldInitialization.Remove(PostWorldInitializationHandle);
+
+	Super::Deinitialize();
+}
+
+void UWorldStateSubsystem::MarkConsumed(const AActor* Actor, int32 WorldStateId)
+{
+	UGameInstance* GameInstance = Actor->GetGameInstance();
+	UWorldStateSubsystem* WorldState = GameInstance ? GameInstance->GetSubsystem<UWorldStateSubsystem>() : nullptr;
+	if (!WorldState || WorldStateId == INDEX_NONE)
+	{
+		return;
+	}
+
+	TBitArray<>& Bits = WorldState->ConsumedActors.FindOrAdd(GetLevelKey(Actor->GetLevel()));
+	if (Bits.Num() <= WorldStateId)
+	{
+		Bits.Add(false, WorldStateId + 1 - Bits.Num());
+	}
+	Bits[WorldStateId] = true;
+}
+
+void UWorldStateSubsystem::CaptureState(const UObject* WorldContextObject, FSaveGameData& Data)
+{
+	UWorld* World = WorldContextObject->GetWorld();
+	UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	UWorldStateSubsystem* WorldState = GameInstance ? GameInstance->GetSubsystem<UWorldStateSubsystem>() : nullptr;
+	if (!WorldState)
+	{
+		return;
+	}
+
+	Data.LevelStates.Reset();
+	for (const TPair<FString, TBitArray<>>& Level : WorldState->ConsumedActors)
+	{
+		TArray<uint32>& Words = Data.LevelStates.Add(Level.Key).ConsumedBits;
+		Words.SetNumZeroed(FMath::DivideAndRoundUp(Level.Value.Num(), 32));
+		for (TConstSetBitIterator<> It(Level.Value); It; ++It)
+		{
+			Words[It.GetIndex() / 32] |= 1u << (It.GetIndex() % 32);
+		}
+	}
+}
+
+void UWorldStateSubsystem::RestoreState(const UObject* WorldContextObject, const FSaveGameData& Data)
+{
+	UWorld* World = WorldContextObject->GetWorld();
+	UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	UWorldStateSubsystem* WorldState = GameInstance ? GameInstance->GetSubsystem<UWorldStateSubsystem>() : nullptr;
+	if (!WorldState)
+	{
+		return;
+	}
+
+	WorldState->ConsumedActors.Reset();
+	for (const TPair<FString, FLevelWorldState>& Level : Data.LevelStates)
+	{
+		const TArray<uint32>& Words = Level.Value.ConsumedBits;
+		TBitArray<>& Bits = WorldState->ConsumedActors.Add(Level.Key);
+		Bits.Init(false, Words.Num() * 32);
+		for (int32 Word = 0; Word < Words.Num(); ++Word)
+		{
+			for (uint32 Remaining = Words[Word]; Remaining; Remaining &= Remaining - 1)
+			{
+				Bits[Word * 32 + FMath::CountTrailingZeros(Remaining)] = true;
+			}
+		}
+	}
+
+	// Loading without a level change keeps the live actors, take out the ones the save has consumed
+	for (ULevel* Level : World->GetLevels())
+	{
+		WorldState->CullConsumed(Level);
+	}
+}
+
+FString UWorldStateSubsystem::GetLevelKey(const ULevel* Level)
+{
+	return UWorld::RemovePIEPrefix(Level->GetOutermost()->GetName());
+}
+
+int32* UWorldStateSubsystem::GetWorldStateId(AActor* Actor)
+{
+	if (Actor->IsA<APickup>() || Actor->IsA<AExplosive>())
+	{
+		return &CastChecked<AItem>(Actor)->WorldStateId;
+	}
+	if (AEnemy* Enemy = Cast<AEnemy>(Actor))
+	{
+		return &Enemy->WorldStateId;
+	}
+	return nullptr;
+}
+
+#if WITH_EDITOR
+void UWorldStateSubsystem::OnPreSaveWorld(uint32 SaveFlags, UWorld* World)
+{
+	// Only levels saved from the editor, the cooker saves what the editor wrote
+	if (World && World->WorldType == EWorldType::Editor && World->PersistentLevel)
+	{
+		AssignWorldStateIds(World->PersistentLevel);
+	}
+}
+
+void UWorldStateSubsystem::AssignWorldStateIds(ULevel* Level)
+{
+	TSet<int32> UsedIds;
+	TArray<int32*> MissingIds;
+	int32 NextId = 0;
+	for (AActor* Actor : Level->Actors)
+	{
+		int32* Id = Actor ? GetWorldStateId(Actor) : nullptr;
+		if (!Id)
+		{
+			continue;
+		}
+
+		bool bAlreadyUsed = false;
+		if (*Id != INDEX_NONE)
+		{
+			UsedIds.Add(*Id, &bAlreadyUsed);
+		}
+		if (*Id == INDEX_NONE || bAlreadyUsed)
+		{
+			MissingIds.Add(Id);
+		}
+		else
+		{
+			NextId = FMath::Max(NextId, *Id + 1);
+		}
+	}
+
+	// Existing ids never change, old saves keep pointing at the same actors
+	for (int32* Id : MissingIds)
+	{
+		*Id = NextId++;
+	}
+}
+#endif
+
+void UWorldStateSubsystem::OnPostWorldInitialization(UWorld* World, const UWorld::InitializationValues IVS)
+{
+	// Actors are loaded but nothing is registered or initialized yet
+	if (World->IsGameWorld() && World->GetGameInstance() == GetGameInstance())
+	{
+		CullConsumed(World->PersistentLevel);
+	}
+}
+
+void UWorldStateSubsystem::CullConsumed(ULevel* Level)
+{
+	const TBitArray<>* Bits = ConsumedActors.Find(GetLevelKey(Level));
+	if (!Bits)
+	{
+		return;
+	}
+
+	TArray<AActor*> Consumed;
+	for (AActor* Actor : Level->Actors)
+	{
+		int32* Id = Actor && !Actor->IsPendingKill() ? GetWorldStateId(Actor) : nullptr;
+		if (Id && *Id >= 0 && *Id < Bits->Num() && (*Bits)[*Id])
+		{
+			Consumed.Add(Actor);
+		}
+	}
+
+	// Destroying edits the actor list, so it happens after the pass
+	for (AActor* Actor : Consumed)
+	{
+		Actor->Destroy();
+	}
+
+	UE_LOG(LogFirstProject, Verbose, TEXT("Culled %d consumed actors from %s"), Consumed.Num(), *GetLevelKey(Level));
+}
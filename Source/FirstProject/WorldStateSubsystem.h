@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Engine/World.h"
+#include "FirstSaveGame.h"
+#include "WorldStateSubsystem.generated.h"
+
+/**
+ * Remembers which placed pickups, explosives and enemies are gone, one bit per actor and level.
+ * Actors are told apart by the WorldStateId the editor assigns when their level is saved; runtime spawned actors
+ * and levels that haven't been saved since have none and aren't tracked.
+ *
+ * Consumed actors are destroyed right after their level is loaded, before components register and
+ * before BeginPlay, so they never set up physics, AI or pickup batching.
+ * Lives on the game instance so the state survives level loads; saves carry it in FSaveGameData::LevelStates.
+ */
+UCLASS()
+class FIRSTPROJECT_API UWorldStateSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Remember that Actor won't come back when its level loads again */
+	static void MarkConsumed(const AActor* Actor, int32 WorldStateId);
+
+	/** Copy the consumed state of every level visited into Data */
+	static void CaptureState(const UObject* WorldContextObject, FSaveGameData& Data);
+
+	/** Replace the consumed state with Data's and remove the actors it consumed from the current world */
+	static void RestoreState(const UObject* WorldContextObject, const FSaveGameData& Data);
+
+	/** Level package name without the PIE prefix */
+	static FString GetLevelKey(const ULevel* Level);
+
+	/** Id of a tracked actor, or null for actors that aren't tracked */
+	static int32* GetWorldStateId(AActor* Actor);
+
+#if WITH_EDITOR
+	/** Bound to FEditorDelegates::PreSaveWorld by the module */
+	static void OnPreSaveWorld(uint32 SaveFlags, UWorld* World);
+
+	/** Give tracked actors in Level that have no id, or share one after being copied, the next free id */
+	static void AssignWorldStateIds(ULevel* Level);
+#endif
+
+private:
+
+	void OnPostWorldInitialization(UWorld* World, const UWorld::InitializationValues IVS);
+
+	/** Destroy the consumed actors of Level in one pass over its actor list */
+	void CullConsumed(ULevel* Level);
+
+	TMap<FString, TBitArray<>> ConsumedActors;
+
+	FDelegateHandle PostWorldInitializationHandle;
+};